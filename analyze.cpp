@@ -1,4 +1,5 @@
 #include "pch.hpp"
+#include "snapshot.hpp"
 #include "turing.hpp"
 
 using namespace std;
@@ -117,9 +118,9 @@ inline vector<int> analyze(turing::TuringMachine m, state_type stateToAnalyze, s
 
 inline turing::TuringMachine bb622() { return {"1RB0RF_1RC0LD_1LB1RC_---0LE_1RA1LE_---0RC"}; }
 
-auto run(turing_rule rule, state_type stateFilter, state_type symbolFilter, size_t steps, size_t width)
+auto run(TuringMachine m, state_type stateFilter, state_type symbolFilter, size_t steps, size_t width)
 {
-    auto res = analyze(rule, stateFilter, symbolFilter, steps, width);
+    auto res = analyze(std::move(m), stateFilter, symbolFilter, steps, width);
     return it::wrap(res).map fun(x, (char)(x >= 10 ? 'A' + x - 10 : '0' + x)).to<string>();
 }
 
@@ -128,6 +129,7 @@ int main(int argc, char *argv[])
     constexpr string_view help = R"(Turing machine macro transition analyzer
 
 Usage: ./run analyze <TM>
+       ./run analyze --from <file>
 
 Arguments:
   <TM>  The Turing machine.
@@ -137,6 +139,8 @@ Options:
   -f, --filter <filter>     The state and/or symbol to filter on, e.g. A, A0, B, B1 (default: A)
   -n, --num-steps <number>  Maximum number of steps (default: 1000)
   -w, --width <number>      Print width of tape output (default: 60)
+  --from <file>             Start from a snapshot saved by simulate instead of
+                            a blank tape
 )";
     const span args(argv, argc);
     turing_rule rule;
@@ -144,6 +148,7 @@ Options:
     symbol_type symbolFilter = -1;
     size_t numSteps = 1000;
     size_t width = 40;
+    string fromPath;
     for (int i = 1; i < argc; ++i)
     {
         if (strcmp(args[i], "-h") == 0 || strcmp(args[i], "--help") == 0)
@@ -161,6 +166,8 @@ Options:
             numSteps = parseNumber(args[++i]);
         else if (strcmp(args[i], "-w") == 0 || strcmp(args[i], "--width") == 0)
             width = parseNumber(args[++i]);
+        else if (strcmp(args[i], "--from") == 0)
+            fromPath = args[++i];
         else if (rule.empty())
         {
             rule = turing_rule(args[i]);
@@ -176,11 +183,25 @@ Options:
             return 0;
         }
     }
+    TuringMachine start{rule};
+    if (!fromPath.empty())
+    {
+        try
+        {
+            start = snapshot::load(fromPath);
+        }
+        catch (const exception &e)
+        {
+            cerr << ansi::red << e.what() << ansi::reset << '\n';
+            return 1;
+        }
+        rule = start.rule();
+    }
     if (rule.empty())
     {
         cout << help;
         return 0;
     }
     ios::sync_with_stdio(false);
-    printTiming(run, rule, stateFilter, symbolFilter, numSteps, width);
+    printTiming(run, std::move(start), stateFilter, symbolFilter, numSteps, width);
 }
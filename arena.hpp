@@ -0,0 +1,148 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "turing.hpp"
+
+namespace turing
+{
+/// A bump allocator for short-lived memory. Nothing is freed individually: `rewind` frees everything that was allocated
+/// since a `mark` at once, and keeps the blocks for the next allocations. This takes malloc and free off hot paths that
+/// create and copy many small tapes, like the enumeration of a subtree or a decider call.
+class Arena
+{
+  public:
+    struct mark_type
+    {
+        size_t block = 0;
+        size_t used = 0;
+    };
+
+    /// Larger allocations are left to `new`: they are rare, and a growing vector would leave a trail of copies behind.
+    static constexpr size_t maxAllocation = 4096;
+
+    explicit Arena(size_t blockSize = 1 << 16) : _blockSize(blockSize) {}
+    Arena(const Arena &) = delete;
+    Arena &operator=(const Arena &) = delete;
+
+    /// Precondition: alignment is a power of two that is at most that of `std::max_align_t`.
+    [[nodiscard]] void *allocate(size_t n, size_t alignment)
+    {
+        assert(alignment <= alignof(std::max_align_t) && std::has_single_bit(alignment));
+        for (; _block < _blocks.size(); ++_block, _used = 0)
+        {
+            const size_t start = (_used + alignment - 1) & ~(alignment - 1);
+            if (start + n <= _blocks[_block].size)
+            {
+                _used = start + n;
+                return _blocks[_block].data.get() + start;
+            }
+        }
+        const size_t size = std::max(_blockSize, n);
+        _blocks.push_back({.data = std::make_unique_for_overwrite<std::byte[]>(size), .size = size});
+        _used = n;
+        return _blocks.back().data.get();
+    }
+
+    [[nodiscard]] mark_type mark() const { return {.block = _block, .used = _used}; }
+
+    /// Frees everything that was allocated since the mark.
+    void rewind(mark_type m)
+    {
+        _block = m.block;
+        _used = m.used;
+    }
+
+    /// The arena that default-constructed `ArenaAllocator`s use on this thread, set by `ArenaScope`.
+    static Arena *&current()
+    {
+        thread_local Arena *arena = nullptr;
+        return arena;
+    }
+
+  private:
+    struct block
+    {
+        std::unique_ptr<std::byte[]> data;
+        size_t size = 0;
+    };
+
+    size_t _blockSize;
+    std::vector<block> _blocks;
+    /// The block that allocations come from, and the number of bytes used in it.
+    size_t _block = 0;
+    size_t _used = 0;
+};
+
+/// Makes an arena the current one of the thread for the lifetime of the scope, and frees what was allocated in it
+/// during the scope when the scope ends. Objects that use the memory must not outlive the scope.
+class ArenaScope
+{
+  public:
+    explicit ArenaScope(Arena &arena)
+        : _arena(arena), _mark(arena.mark()), _previous(std::exchange(Arena::current(), &arena))
+    {
+    }
+    ArenaScope(const ArenaScope &) = delete;
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+    ~ArenaScope()
+    {
+        _arena.rewind(_mark);
+        Arena::current() = _previous;
+    }
+
+  private:
+    Arena &_arena;
+    Arena::mark_type _mark;
+    Arena *_previous;
+};
+
+/// An allocator that allocates from an arena, or with `new` if it has none or the allocation is large. A
+/// default-constructed allocator takes the current arena of the thread, and the allocator propagates with its
+/// container, so copies of a tape stay in the arena of the original.
+template <typename T> class ArenaAllocator
+{
+  public:
+    using value_type = T;
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    ArenaAllocator() : _arena(Arena::current()) {}
+    explicit ArenaAllocator(Arena *arena) : _arena(arena) {}
+    template <typename U> ArenaAllocator(const ArenaAllocator<U> &other) : _arena(other.arena()) {}
+
+    [[nodiscard]] T *allocate(size_t n)
+    {
+        if (_arena == nullptr || n * sizeof(T) > Arena::maxAllocation)
+            return std::allocator<T>{}.allocate(n);
+        return static_cast<T *>(_arena->allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T *p, size_t n)
+    {
+        if (_arena == nullptr || n * sizeof(T) > Arena::maxAllocation)
+            std::allocator<T>{}.deallocate(p, n);
+    }
+
+    [[nodiscard]] Arena *arena() const { return _arena; }
+
+    template <typename U> bool operator==(const ArenaAllocator<U> &other) const { return _arena == other.arena(); }
+
+  private:
+    Arena *_arena;
+};
+
+/// A tape whose cells are allocated in an arena.
+using ArenaTape = BasicTape<ArenaAllocator<symbol_type>>;
+/// A Turing machine whose tape is allocated in an arena.
+using ArenaTuringMachine = BasicTuringMachine<ArenaTape>;
+} // namespace turing
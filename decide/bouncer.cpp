@@ -10,7 +10,7 @@ using namespace turing;
 
 void run(turing_rule rule, size_t degree, size_t numSteps, size_t maxPeriod, size_t confidenceLevel, bool verbose)
 {
-    auto res = BouncerDecider{verbose}.find(rule, degree, numSteps, maxPeriod, confidenceLevel);
+    auto res = BouncerDecider{verbose}.find(TuringMachine{rule}, degree, numSteps, maxPeriod, confidenceLevel);
     if (res.found)
         cout << "(degree, start, xPeriod, side, steps) = "
              << tuple{res.degree, res.start, res.xPeriod, res.side == direction::left ? 'L' : 'R', res.steps} << '\n';
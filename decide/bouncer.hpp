@@ -25,16 +25,42 @@ struct record
     state_type state = 0;
 };
 
+/// A bouncer search in progress: the machine and the records of its tape growth so far.
+template <typename Machine = TuringMachine> struct bouncer_session
+{
+    Machine m;
+    std::vector<record> records{{}};
+};
+
 class BouncerDecider
 {
   public:
     constexpr explicit BouncerDecider(bool verbose = false) : _verbose(verbose) {}
 
-    /// Precondition: degree ≥ 1.
-    [[nodiscard]] bouncer_result find(TuringMachine m, size_t degree, size_t maxSteps, size_t maxPeriod,
-                                      size_t confidenceLevel = 5) const
+    /// Starts a search, which `extend` runs.
+    template <typename Machine = TuringMachine> [[nodiscard]] static bouncer_session<Machine> session(Machine m)
     {
-        std::vector<record> records{{}};
+        return {.m = std::move(m)};
+    }
+
+    /// Searches the growth records of the session, then continues the simulation until the machine halts or has taken
+    /// `maxSteps` steps. The result is the same as that of `find` with the same arguments, so the session can be
+    /// searched again with other parameters or a larger budget at the cost of the extra steps only. Precondition:
+    /// degree ≥ 1.
+    template <typename Machine>
+    [[nodiscard]] bouncer_result extend(bouncer_session<Machine> &s, size_t degree, size_t maxSteps, size_t maxPeriod,
+                                        size_t confidenceLevel = 5) const
+    {
+        auto &m = s.m;
+        auto &records = s.records;
+        record_index index;
+        // Check the records that are already known, as a fresh search would have after each of them
+        for (size_t n = 2; n <= records.size() && records[n - 1].t <= maxSteps; ++n)
+        {
+            auto res = checkRecords(index, {records.data(), n}, degree, maxPeriod, confidenceLevel);
+            if (res.found)
+                return res;
+        }
         while (!m.halted() && m.steps() < maxSteps)
         {
             auto res = m.step();
@@ -52,22 +78,75 @@ class BouncerDecider
                 print(m) << ansi::reset;
             }
             records.push_back(rec);
-            const auto hp = std::min(maxPeriod, (records.size() - 1) / (degree + confidenceLevel - 1));
-            for (size_t p = 1; p <= hp; ++p)
+            auto found = checkRecords(index, records, degree, maxPeriod, confidenceLevel);
+            if (found.found)
+                return found;
+        }
+        return {};
+    }
+
+    /// Precondition: degree ≥ 1.
+    template <typename Machine = TuringMachine>
+    [[nodiscard]] bouncer_result find(Machine m, size_t degree, size_t maxSteps, size_t maxPeriod,
+                                      size_t confidenceLevel = 5) const
+    {
+        auto s = session(std::move(m));
+        return extend(s, degree, maxSteps, maxPeriod, confidenceLevel);
+    }
+
+  private:
+    /// The records of each type, so that a new record only visits the x periods that lead back to a record of its
+    /// type, and a buffer for the finite differences.
+    struct record_index
+    {
+        std::vector<std::vector<size_t>> byType;
+        std::vector<int64_t> w;
+
+        std::vector<size_t> &operator[](const record &r)
+        {
+            const size_t type = (size_t)(uint8_t)r.state << 1 | (size_t)(r.side == direction::right);
+            if (byType.size() <= type)
+                byType.resize(type + 1);
+            return byType[type];
+        }
+    };
+
+    bool _verbose;
+
+    /// Checks the last records for each x period. `index` must have the records before the last one.
+    [[nodiscard]] bouncer_result checkRecords(record_index &index, std::span<const record> v, size_t degree,
+                                              size_t maxPeriod, size_t confidenceLevel) const
+    {
+        const size_t last = v.size() - 1;
+        const size_t n = degree + confidenceLevel;
+        const auto hp = std::min(maxPeriod, last / (n - 1));
+        // The window that starts at the initial record, which matches either side, isn't found through the index.
+        size_t p0 = last % (n - 1) == 0 && last / (n - 1) <= hp ? last / (n - 1) : 0;
+        auto &sameType = index[v.back()];
+        for (auto it = sameType.rbegin(); it != sameType.rend() && last - *it <= hp; ++it)
+        {
+            const size_t p = last - *it;
+            if (p0 != 0 && p0 < p)
             {
-                auto res = checkPoly(records, degree, p, confidenceLevel);
+                auto res = checkPoly(v, degree, std::exchange(p0, 0), confidenceLevel, index.w);
                 if (res.found)
                     return res;
             }
+            if (p == p0)
+                p0 = 0;
+            auto res = checkPoly(v, degree, p, confidenceLevel, index.w);
+            if (res.found)
+                return res;
         }
+        sameType.push_back(last);
+        if (p0 != 0)
+            return checkPoly(v, degree, p0, confidenceLevel, index.w);
         return {};
     }
 
-  private:
-    bool _verbose;
-
-    [[nodiscard]] bouncer_result checkPoly(const std::vector<record> &v, size_t degree, size_t p,
-                                           size_t confidenceLevel) const
+    /// `w` is a buffer for the finite differences.
+    [[nodiscard]] bouncer_result checkPoly(std::span<const record> v, size_t degree, size_t p, size_t confidenceLevel,
+                                           std::vector<int64_t> &w) const
     {
         const size_t n = degree + confidenceLevel; // Number of elements to check
         const size_t N = 1 + (n - 1) * p;          // Size of range to check
@@ -76,14 +155,12 @@ class BouncerDecider
         auto start = v.end() - N;
         if (!sameRecordType(*start, v.back()))
             return {};
-        std::vector w(n, (int64_t)start->t);
-        for (size_t i = 1; i < n; ++i)
-        {
-            const auto rec = start + i * p;
-            if (!sameRecordType(*rec, *start))
+        for (size_t i = 1; i < n - 1; ++i)
+            if (!sameRecordType(start[i * p], *start))
                 return {};
-            w[i] = rec->t;
-        }
+        w.resize(n);
+        for (size_t i = 0; i < n; ++i)
+            w[i] = (int64_t)start[i * p].t;
         // Calculate iterated finite differences
         for (size_t d = 1; d <= degree; ++d)
         {
@@ -112,7 +189,7 @@ class BouncerDecider
         return (a.t == 0 || b.t == 0 || a.side == b.side) && a.state == b.state;
     }
 
-    static std::ostream &print(const TuringMachine &m)
+    template <typename Machine> static std::ostream &print(const Machine &m)
     {
         std::cout << std::setw(6) << m.tape().size() << " | " << std::setw(10) << m.steps();
         std::cout << " | " << m.prettyStr(40) << '\n';
@@ -0,0 +1,169 @@
+// Certifies bouncers and verifies the certificates in bulk.
+
+#include "../pch.hpp"
+
+#include <tbb/blocked_range.h>
+#include <tbb/info.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
+
+#include "certified_bouncer.hpp"
+
+using namespace std;
+using namespace turing;
+
+/// Reads the lines of a file, or of standard input for "-".
+vector<string> readLines(const string &path)
+{
+    ifstream file;
+    if (path != "-")
+    {
+        file.open(path);
+        if (!file)
+            throw runtime_error("Failed to open " + path);
+    }
+    istream &in = path == "-" ? cin : file;
+    vector<string> lines;
+    for (string line; getline(in, line);)
+        if (!line.empty())
+            lines.push_back(std::move(line));
+    return lines;
+}
+
+/// Runs `f(i)` for each line number in parallel.
+template <typename F> void forEachLine(size_t n, size_t threads, F &&f)
+{
+    tbb::task_arena arena((int)threads);
+    arena.execute([&] {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, n), [&](const tbb::blocked_range<size_t> &r) {
+            for (size_t i = r.begin(); i < r.end(); ++i)
+                f(i);
+        });
+    });
+}
+
+/// Certifies the machines of the lines, each the first field that isn't a number, so the output of enumerate works.
+/// Prints a line with the machine and its certificate for each one that is certified.
+void certify(const vector<string> &lines, size_t numSteps, size_t maxPeriod, size_t threads)
+{
+    vector<string> out(lines.size());
+    forEachLine(lines.size(), threads, [&](size_t i) {
+        istringstream fields(lines[i]);
+        string field;
+        while (fields >> field && ranges::all_of(field, [](char ch) { return isdigit((unsigned char)ch); }))
+            ;
+        const turing_rule rule(field);
+        if (rule.empty())
+            return;
+        const auto res = CertifiedBouncerDecider{}.find(TuringMachine{rule}, numSteps, maxPeriod);
+        if (res.found)
+            out[i] = rule.str() + ' ' + res.certificate.str();
+    });
+    size_t certified = 0;
+    for (const auto &line : out)
+        if (!line.empty())
+        {
+            cout << line << '\n';
+            ++certified;
+        }
+    cerr << "Certified " << certified << " of " << lines.size() << " machines\n";
+}
+
+/// Verifies lines of a machine and its certificate, printing the ones that fail.
+bool verify(const vector<string> &lines, size_t threads)
+{
+    vector<uint8_t> valid(lines.size());
+    forEachLine(lines.size(), threads, [&](size_t i) {
+        const string_view line = lines[i];
+        const auto space = line.find(' ');
+        if (space == string_view::npos)
+            return;
+        const turing_rule rule(string(line.substr(0, space)));
+        const auto c = bouncer_certificate::parse(line.substr(space + 1));
+        valid[i] = !rule.empty() && c && CertifiedBouncerDecider::verify(rule, *c);
+    });
+    size_t failed = 0;
+    for (size_t i = 0; i < lines.size(); ++i)
+        if (!valid[i])
+        {
+            cout << ansi::red << "Line " << i + 1 << " failed: " << ansi::reset << lines[i] << '\n';
+            ++failed;
+        }
+    cout << "Verified " << lines.size() - failed << " of " << lines.size() << " certificates\n";
+    return failed == 0;
+}
+
+int main(int argc, char *argv[])
+{
+    constexpr string_view help =
+        R"(Certifies bouncers, and verifies the certificates in bulk.
+
+Usage: ./run decide/bouncer_certs certify <file>
+       ./run decide/bouncer_certs verify <file>
+
+Arguments:
+  <file>  Machines to certify, one per line (the output of enumerate works), or
+          lines of a machine and its certificate to verify, as certify prints
+          them. "-" reads standard input.
+
+Options:
+  -h, --help           Show this help message
+  -j, --threads <n>    The number of threads (default: all)
+  -n, --num-steps <n>  The number of steps to run each machine for (default: 1e6)
+  -p, --period <n>     The maximum x-period of the growth (default: 3000)
+
+Comments:
+  A certificate is a step and a formula of the tape at that step, of walls and
+  repeaters like "10 (011)^5 A0 (1)^7". Verifying runs the machine to that step
+  and proves the formula symbolically, which is much faster than certifying.
+)";
+    const span args(argv, argc);
+    string mode;
+    string path;
+    size_t threads = tbb::info::default_concurrency();
+    size_t numSteps = 1'000'000;
+    size_t maxPeriod = 3000;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(args[i], "-h") == 0 || strcmp(args[i], "--help") == 0)
+        {
+            cout << help;
+            return 0;
+        }
+        if (strcmp(args[i], "-j") == 0 || strcmp(args[i], "--threads") == 0)
+            threads = max(parseNumber(args[++i]), 1UZ);
+        else if (strcmp(args[i], "-n") == 0 || strcmp(args[i], "--num-steps") == 0)
+            numSteps = parseNumber(args[++i]);
+        else if (strcmp(args[i], "-p") == 0 || strcmp(args[i], "--period") == 0)
+            maxPeriod = parseNumber(args[++i]);
+        else if (mode.empty())
+            mode = args[i];
+        else if (path.empty())
+            path = args[i];
+        else
+        {
+            cerr << ansi::red << "Unexpected argument: " << ansi::reset << args[i] << '\n' << help;
+            return 0;
+        }
+    }
+    if ((mode != "certify" && mode != "verify") || path.empty())
+    {
+        cout << help;
+        return 0;
+    }
+    try
+    {
+        const auto lines = readLines(path);
+        bool ok = true;
+        if (mode == "certify")
+            printTiming(certify, lines, numSteps, maxPeriod, threads);
+        else
+            printTiming([&] { ok = verify(lines, threads); });
+        return ok ? 0 : 1;
+    }
+    catch (const exception &e)
+    {
+        cerr << ansi::red << e.what() << ansi::reset << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,189 @@
+#pragma once
+
+#include "../turing.hpp"
+
+namespace turing
+{
+struct brent_cycler_result
+{
+    size_t period = 0;
+    /// Steps before the cycle, counting the steps that the machine had already taken.
+    size_t preperiod = 0;
+    /// Number of steps that the search simulated.
+    size_t steps = 0;
+};
+
+/// Detects cyclers, machines whose configuration eventually repeats, with Brent's cycle detection: a saved
+/// configuration, the tortoise, is compared to the running one after each step, and jumps to it at the end of each lap,
+/// where laps grow geometrically until one is longer than the period. Unlike `CyclerDecider`, which compares spans of
+/// the tapes, a comparison takes constant time: the decider keeps count of the cells where the two tapes differ as the
+/// running machine writes. There are no machines to copy, and memory is proportional to the tape, not to the period.
+class BrentCyclerDecider
+{
+  public:
+    /// `lapGrowth` is the ratio of consecutive laps, 2 in Brent's algorithm. Smaller ratios find cycles with long
+    /// preperiods in fewer steps, at the cost of more copies of the tape.
+    constexpr explicit BrentCyclerDecider(double lapGrowth = 2) : _lapGrowth(lapGrowth) {}
+
+    /// Finds the period of the machine, with a first lap of `startPeriodBound` steps. Laps that start within `maxSteps`
+    /// steps of the current configuration are finished. The preperiod is only an upper bound. Returns period 0 if the
+    /// machine halts or no cycle is detected.
+    template <typename Machine>
+    [[nodiscard]] brent_cycler_result findPeriodOnly(const Machine &machine, size_t maxSteps,
+                                                     size_t startPeriodBound = 1) const
+    {
+        const transition_table table{machine.rule()};
+        configuration_pair c{machine.tape(), table};
+        size_t steps = 0;
+        for (size_t lap = startPeriodBound; steps <= maxSteps;
+             lap = std::max(lap + 1, (size_t)((double)lap * _lapGrowth)))
+        {
+            // The tortoise jumps to the hare
+            c.save();
+            const size_t n = c.run(0, table, lap);
+            steps += n;
+            if (c.equal())
+                return {.period = n, .preperiod = machine.steps() + steps - n, .steps = steps};
+            if (n < lap)
+                break;
+        }
+        return {.period = 0, .preperiod = 0, .steps = steps};
+    }
+
+    /// Finds the period and the exact preperiod of the machine, like `findPeriodOnly`. The preperiod takes a second
+    /// pass of the period plus twice the preperiod.
+    template <typename Machine>
+    [[nodiscard]] brent_cycler_result find(const Machine &machine, size_t maxSteps, size_t startPeriodBound = 1) const
+    {
+        auto res = findPeriodOnly(machine, maxSteps, startPeriodBound);
+        if (res.period == 0)
+            return res;
+        // The first repeated configuration is where two runs that are a period apart meet.
+        const transition_table table{machine.rule()};
+        configuration_pair c{machine.tape(), table};
+        c.run(0, table, res.period);
+        size_t preperiod = 0;
+        for (; !c.equal(); ++preperiod)
+        {
+            c.run(0, table, 1);
+            c.run(1, table, 1);
+        }
+        res.preperiod = machine.steps() + preperiod;
+        res.steps += res.period + 2 * preperiod;
+        return res;
+    }
+
+  private:
+    double _lapGrowth;
+
+    /// Two configurations of a machine on tapes with a common origin, with the number of cells where the tapes differ.
+    class configuration_pair
+    {
+      public:
+        /// Both configurations start as that of the tape.
+        template <typename TapeType>
+        configuration_pair(const TapeType &tape, const transition_table &table) : _offset(-tape.leftEdge())
+        {
+            auto &c = _configs[0];
+            c.cells.resize(tape.size());
+            for (int64_t i = tape.leftEdge(); i <= tape.rightEdge(); ++i)
+                c.cells[i + _offset] = tape[i];
+            c.pos = tape.head() + _offset;
+            const auto state = (state_type)tape.state();
+            c.row = table.halts(state) ? transition_table::haltRow : table.row(state);
+            save();
+        }
+
+        [[nodiscard]] bool equal() const
+        {
+            return _diff == 0 && _configs[0].pos == _configs[1].pos && _configs[0].row == _configs[1].row;
+        }
+
+        /// Makes the second configuration a copy of the first.
+        void save()
+        {
+            _configs[1] = _configs[0];
+            _diff = 0;
+        }
+
+        /// Runs up to `n` steps of configuration `i`, with its tape and head in locals. Stops early if the machine
+        /// halts, or after a step that makes the configurations equal. Returns the number of steps run.
+        size_t run(size_t i, const transition_table &table, size_t n)
+        {
+            auto &self = _configs[i];
+            const auto &other = _configs[1 - i];
+            const flat_transition *t = table.data();
+            symbol_type *d = self.cells.data();
+            const symbol_type *e = other.cells.data();
+            int64_t p = self.pos;
+            auto hi = (int64_t)self.cells.size() - 1;
+            uint8_t row = self.row;
+            int64_t diff = _diff;
+            int64_t otherPos = other.pos;
+            const uint8_t otherRow = other.row;
+            size_t k = 0;
+            while (k < n && row != transition_table::haltRow)
+            {
+                const symbol_type old = d[p];
+                const auto tr = t[row + old];
+                diff += (int64_t)(tr.symbol != e[p]) - (int64_t)(old != e[p]);
+                d[p] = tr.symbol;
+                row = tr.next;
+                p += tr.delta;
+                ++k;
+                if (p < 0 || p > hi)
+                {
+                    const auto shift = grow(p < 0);
+                    p += shift;
+                    otherPos += shift;
+                    hi = (int64_t)self.cells.size() - 1;
+                    d = self.cells.data();
+                    e = other.cells.data();
+                }
+                if (diff == 0 && row == otherRow && p == otherPos)
+                    break;
+            }
+            self.pos = p;
+            self.row = row;
+            _diff = diff;
+            return k;
+        }
+
+      private:
+        struct configuration
+        {
+            std::vector<symbol_type> cells;
+            /// The index of the head in `cells`.
+            int64_t pos = 0;
+            /// The row of the state in the transition table.
+            uint8_t row = 0;
+        };
+
+        std::array<configuration, 2> _configs{};
+        /// The index in the tapes of position 0.
+        int64_t _offset;
+        /// The number of cells where the tapes differ.
+        int64_t _diff = 0;
+
+        /// Extends both tapes by a blank cell on the left or right, doubling them to the left like `Tape`. Returns the
+        /// shift of the indices.
+        int64_t grow(bool left)
+        {
+            if (!left)
+            {
+                for (auto &c : _configs)
+                    c.cells.push_back(0);
+                return 0;
+            }
+            const auto size = (int64_t)_configs[0].cells.size();
+            for (auto &c : _configs)
+            {
+                c.cells.insert(c.cells.begin(), size, 0);
+                c.pos += size;
+            }
+            _offset += size;
+            return size;
+        }
+    };
+};
+} // namespace turing
@@ -0,0 +1,569 @@
+#pragma once
+
+#include <charconv>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "bouncer.hpp"
+
+namespace turing
+{
+/// A tape of walls, which are fixed words, and repeaters, which are words repeated some number of times. Walls and
+/// repeaters alternate, starting and ending with a wall, and the rest of the tape is blank. The head is on a cell of a
+/// wall.
+struct tape_formula
+{
+    struct repeater
+    {
+        std::vector<symbol_type> word;
+        size_t count = 0;
+
+        friend bool operator==(const repeater &, const repeater &) = default;
+    };
+
+    std::vector<std::vector<symbol_type>> walls{{}};
+    /// `repeaters[i]` is between `walls[i]` and `walls[i + 1]`.
+    std::vector<repeater> repeaters;
+    size_t headWall = 0;
+    size_t headCell = 0;
+    state_type state = 0;
+
+    friend bool operator==(const tape_formula &, const tape_formula &) = default;
+
+    /// Walls are written as digits with the state letter before the head cell and repeaters as `(word)^count`,
+    /// separated by spaces. Empty walls are left out.
+    [[nodiscard]] std::string str() const
+    {
+        std::string s;
+        const auto add = [&](const std::string &token) {
+            if (!s.empty())
+                s += ' ';
+            s += token;
+        };
+        for (size_t i = 0; i < walls.size(); ++i)
+        {
+            if (!walls[i].empty())
+            {
+                std::string token;
+                for (size_t j = 0; j < walls[i].size(); ++j)
+                {
+                    if (i == headWall && j == headCell)
+                        token += (char)('A' + state);
+                    token += (char)('0' + walls[i][j]);
+                }
+                add(token);
+            }
+            if (i < repeaters.size())
+            {
+                std::string token = "(";
+                for (const auto symbol : repeaters[i].word)
+                    token += (char)('0' + symbol);
+                add(token + ")^" + std::to_string(repeaters[i].count));
+            }
+        }
+        return s;
+    }
+
+    /// Parses the output of `str`. Returns `std::nullopt` if `s` is not a formula.
+    [[nodiscard]] static std::optional<tape_formula> parse(std::string_view s)
+    {
+        tape_formula f;
+        f.walls.clear();
+        bool hasHead = false;
+        bool afterWall = false;
+        const auto isDigit = [](char ch) { return ch >= '0' && ch < (char)('0' + maxSymbols); };
+        while (!s.empty())
+        {
+            const auto token = s.substr(0, s.find(' '));
+            s.remove_prefix(std::min(s.size(), token.size() + 1));
+            if (token.empty())
+                continue;
+            if (token.front() == '(')
+            {
+                const auto close = token.find(")^");
+                if (close == std::string_view::npos || close == 1)
+                    return std::nullopt;
+                repeater r;
+                for (const char ch : token.substr(1, close - 1))
+                {
+                    if (!isDigit(ch))
+                        return std::nullopt;
+                    r.word.push_back(ch - '0');
+                }
+                const auto count = token.substr(close + 2);
+                if (std::from_chars(count.data(), count.data() + count.size(), r.count).ptr !=
+                        count.data() + count.size() ||
+                    count.empty())
+                    return std::nullopt;
+                if (!afterWall)
+                    f.walls.emplace_back();
+                f.repeaters.push_back(std::move(r));
+                afterWall = false;
+                continue;
+            }
+            if (afterWall)
+                return std::nullopt;
+            auto &wall = f.walls.emplace_back();
+            for (size_t j = 0; j < token.size(); ++j)
+            {
+                if (isDigit(token[j]))
+                    wall.push_back(token[j] - '0');
+                else if (token[j] >= 'A' && token[j] < (char)('A' + maxStates) && !hasHead && j + 1 < token.size() &&
+                         isDigit(token[j + 1]))
+                {
+                    hasHead = true;
+                    f.headWall = f.walls.size() - 1;
+                    f.headCell = wall.size();
+                    f.state = (state_type)(token[j] - 'A');
+                }
+                else
+                    return std::nullopt;
+            }
+            afterWall = true;
+        }
+        if (!afterWall)
+            f.walls.emplace_back();
+        if (!hasHead)
+            return std::nullopt;
+        return f;
+    }
+
+    /// The cells from the first to the last nonblank one, and the head if it is outside them, and the index of the
+    /// head among them.
+    [[nodiscard]] std::pair<std::vector<symbol_type>, size_t> cells() const
+    {
+        std::vector<symbol_type> v;
+        size_t head = 0;
+        for (size_t i = 0; i < walls.size(); ++i)
+        {
+            if (i == headWall)
+                head = v.size() + headCell;
+            v.insert(v.end(), walls[i].begin(), walls[i].end());
+            if (i < repeaters.size())
+                for (size_t k = 0; k < repeaters[i].count; ++k)
+                    v.insert(v.end(), repeaters[i].word.begin(), repeaters[i].word.end());
+        }
+        return trimBlanks(std::move(v), head);
+    }
+
+    /// Whether the cells of this formula, with its counts, number at most `maxCells`, so that `cells` can expand them.
+    [[nodiscard]] bool fits(size_t maxCells) const
+    {
+        size_t n = 0;
+        for (const auto &wall : walls)
+            if ((n += wall.size()) > maxCells)
+                return false;
+        for (const auto &r : repeaters)
+            if (r.count > (maxCells - n) / r.word.size() || (n += r.count * r.word.size()) > maxCells)
+                return false;
+        return true;
+    }
+
+    /// Whether this formula, with its counts, is the tape of `m`.
+    template <typename Machine> [[nodiscard]] bool matches(const Machine &m) const
+    {
+        std::vector<symbol_type> v;
+        for (int64_t i = m.tape().leftEdge(); i <= m.tape().rightEdge(); ++i)
+            v.push_back(m.tape()[i]);
+        return m.state() == state && cells() == trimBlanks(std::move(v), m.head() - m.tape().leftEdge());
+    }
+
+    /// Builds a formula for the tape of `m`, taking runs of at least `minRepeats` copies of a word of `minWordLength`
+    /// to `maxWordLength` cells as repeaters, greedily from the left.
+    template <typename Machine>
+    [[nodiscard]] static tape_formula of(const Machine &m, size_t minRepeats, size_t minWordLength,
+                                         size_t maxWordLength)
+    {
+        std::vector<symbol_type> cells;
+        for (int64_t i = m.tape().leftEdge(); i <= m.tape().rightEdge(); ++i)
+            cells.push_back(m.tape()[i]);
+        const auto [v, head] = trimBlanks(std::move(cells), m.head() - m.tape().leftEdge());
+        tape_formula f;
+        f.state = m.state();
+        for (size_t i = 0; i < v.size();)
+        {
+            // The repeater that covers the most cells, without covering the head
+            size_t bestLength = 0;
+            size_t bestCount = 0;
+            for (size_t length = minWordLength; length <= maxWordLength && i + length * minRepeats <= v.size();
+                 ++length)
+            {
+                size_t count = 1;
+                while (i + (count + 1) * length <= v.size() &&
+                       std::equal(v.begin() + i, v.begin() + i + length, v.begin() + i + count * length))
+                    ++count;
+                if (head >= i)
+                    count = std::min(count, (head - i) / length);
+                if (count >= minRepeats && count * length > bestCount * bestLength)
+                {
+                    bestLength = length;
+                    bestCount = count;
+                }
+            }
+            if (bestLength != 0)
+            {
+                f.repeaters.push_back({.word = {v.begin() + i, v.begin() + i + bestLength}, .count = bestCount});
+                f.walls.emplace_back();
+                i += bestLength * bestCount;
+                continue;
+            }
+            if (i == head)
+            {
+                f.headWall = f.walls.size() - 1;
+                f.headCell = f.walls.back().size();
+            }
+            f.walls.back().push_back(v[i++]);
+        }
+        return f;
+    }
+
+    /// Moves copies of the words of the repeaters from the ends of the walls next to them into the repeaters, and
+    /// removes blank cells at the ends of the tape, except under the head. The tape stays the same.
+    void normalize()
+    {
+        const auto headIn = [&](size_t i, size_t from, size_t to) {
+            return headWall == i && headCell >= from && headCell < to;
+        };
+        auto &first = walls.front();
+        while (!first.empty() && first.front() == 0 && !headIn(0, 0, 1))
+        {
+            first.erase(first.begin());
+            if (headWall == 0)
+                --headCell;
+        }
+        auto &last = walls.back();
+        while (!last.empty() && last.back() == 0 && !headIn(walls.size() - 1, last.size() - 1, last.size()))
+            last.pop_back();
+        for (size_t i = 0; i < walls.size(); ++i)
+        {
+            auto &wall = walls[i];
+            if (i > 0)
+            {
+                auto &r = repeaters[i - 1];
+                while (wall.size() >= r.word.size() && std::equal(r.word.begin(), r.word.end(), wall.begin()) &&
+                       !headIn(i, 0, r.word.size()))
+                {
+                    wall.erase(wall.begin(), wall.begin() + (ptrdiff_t)r.word.size());
+                    ++r.count;
+                    if (headWall == i)
+                        headCell -= r.word.size();
+                }
+            }
+            if (i < repeaters.size())
+            {
+                auto &r = repeaters[i];
+                while (wall.size() >= r.word.size() &&
+                       std::equal(r.word.begin(), r.word.end(), wall.end() - (ptrdiff_t)r.word.size()) &&
+                       !headIn(i, wall.size() - r.word.size(), wall.size()))
+                {
+                    wall.resize(wall.size() - r.word.size());
+                    ++r.count;
+                }
+            }
+        }
+    }
+
+  private:
+    static std::pair<std::vector<symbol_type>, size_t> trimBlanks(std::vector<symbol_type> v, size_t head)
+    {
+        while (!v.empty() && v.back() == 0 && v.size() > head + 1)
+            v.pop_back();
+        size_t lead = 0;
+        while (lead < v.size() && v[lead] == 0 && lead < head)
+            ++lead;
+        v.erase(v.begin(), v.begin() + (ptrdiff_t)lead);
+        return {std::move(v), head - lead};
+    }
+};
+
+/// A proof that a machine is a bouncer: at step `start` its tape is `formula`, and from any tape of that formula, with
+/// any counts, the machine reaches the same formula with counts that are no smaller.
+struct bouncer_certificate
+{
+    size_t start = 0;
+    tape_formula formula;
+
+    /// The start step followed by the formula.
+    [[nodiscard]] std::string str() const { return std::to_string(start) + ' ' + formula.str(); }
+
+    /// Parses the output of `str`. Returns `std::nullopt` if `s` is not a certificate.
+    [[nodiscard]] static std::optional<bouncer_certificate> parse(std::string_view s)
+    {
+        bouncer_certificate c;
+        const auto [ptr, ec] = std::from_chars(s.data(), s.data() + s.size(), c.start);
+        if (ec != std::errc{} || ptr == s.data() + s.size() || *ptr != ' ')
+            return std::nullopt;
+        auto formula = tape_formula::parse(s.substr(ptr - s.data() + 1));
+        if (!formula)
+            return std::nullopt;
+        c.formula = std::move(*formula);
+        return c;
+    }
+};
+
+struct certified_bouncer_result
+{
+    bool found = false;
+    bouncer_certificate certificate;
+    /// The number of steps simulated.
+    size_t steps = 0;
+};
+
+/// Decides bouncers with a certificate that `verify` checks. After `BouncerDecider` finds polynomial growth in the
+/// records, a formula of the tape is built at each following record and proved by simulating it symbolically: the head
+/// runs through a repeater by a shift rule, which is proved by running the machine on one copy of its word and
+/// requiring the head to leave it on the other side in the state that it came in with, so every copy changes the same
+/// way. The proof succeeds when the formula comes back with the same walls, words and head, and no smaller counts.
+class CertifiedBouncerDecider
+{
+  public:
+    /// The most symbolic steps of a proof, counting the steps of the shift rules.
+    static constexpr size_t maxProofSteps = 1'000'000;
+
+    /// Finds a certificate within `maxSteps` steps, trying the formulas of up to `attempts` records after the growth
+    /// is found.
+    template <typename Machine = TuringMachine>
+    [[nodiscard]] certified_bouncer_result find(Machine m, size_t maxSteps, size_t maxPeriod = 3000,
+                                                size_t attempts = 16) const
+    {
+        const BouncerDecider decider;
+        auto s = decider.session(std::move(m));
+        const auto growth = decider.extend(s, 2, maxSteps, maxPeriod, 6);
+        if (!growth.found)
+            return {.found = false, .certificate = {}, .steps = s.m.steps()};
+        bool expanded = false;
+        const auto untilExpanded = [&](const step_info &info) { return expanded = info.tapeExpanded; };
+        for (size_t k = 0; k < attempts; ++k)
+        {
+            for (const auto &[minRepeats, minWordLength] : formulaShapes)
+            {
+                const auto f = tape_formula::of(s.m, minRepeats, minWordLength, maxWordLength);
+                if (prove(s.m.rule(), f))
+                    return {.found = true,
+                            .certificate = {.start = s.m.steps(), .formula = f},
+                            .steps = s.m.steps()};
+            }
+            expanded = false;
+            s.m.runUntil(untilExpanded, maxSteps - std::min(maxSteps, s.m.steps()));
+            if (!expanded)
+                break;
+        }
+        return {.found = false, .certificate = {}, .steps = s.m.steps()};
+    }
+
+    /// Checks a certificate: runs the machine to its start, compares the tape to the formula, and proves the formula.
+    [[nodiscard]] static bool verify(const turing_rule &rule, const bouncer_certificate &c)
+    {
+        for (const auto &wall : c.formula.walls)
+            for (const auto symbol : wall)
+                if (symbol >= rule.numSymbols())
+                    return false;
+        for (const auto &r : c.formula.repeaters)
+            for (const auto symbol : r.word)
+                if (symbol >= rule.numSymbols())
+                    return false;
+        if ((size_t)c.formula.state >= rule.numStates())
+            return false;
+        // The head visits at most one new cell a step, so a longer formula can't be the tape
+        if (c.start == std::numeric_limits<size_t>::max() || !c.formula.fits(c.start + 1))
+            return false;
+        TuringMachine m{rule};
+        if (m.stepN(c.start) != c.start)
+            return false;
+        return c.formula.matches(m) && prove(rule, c.formula);
+    }
+
+    /// Proves that the machine never halts from any tape of the formula `f` with any counts.
+    [[nodiscard]] static bool prove(const turing_rule &rule, tape_formula f)
+    {
+        f.normalize();
+        const auto start = f;
+        const auto cells = [](const tape_formula &g) {
+            size_t n = 0;
+            for (const auto &wall : g.walls)
+                n += wall.size();
+            return n;
+        };
+        // Give up once the walls grow far beyond their start, since a bouncer moves the copies that it adds into the
+        // repeaters.
+        const size_t maxCells = 2 * cells(start) + 2 * maxWordLength * (start.repeaters.size() + 1);
+        size_t steps = 0;
+        while (steps < maxProofSteps)
+        {
+            if (!step(rule, f, steps) || cells(f) > maxCells)
+                return false;
+            if (f.state != start.state || f.headWall != start.headWall)
+                continue;
+            auto g = f;
+            g.normalize();
+            if (sameShape(g, start))
+                return true;
+        }
+        return false;
+    }
+
+  private:
+    /// The longest repeater word in the formulas that `find` tries.
+    static constexpr size_t maxWordLength = 16;
+    /// The least repeats and word lengths of repeaters in the formulas that `find` tries.
+    static constexpr std::array<std::pair<size_t, size_t>, 6> formulaShapes{
+        {{2, 1}, {3, 1}, {2, 2}, {3, 2}, {2, 3}, {2, 4}}};
+    /// The most cells of a wall that the head carries across a repeater.
+    static constexpr size_t maxCarried = 8;
+
+    /// Whether `a` has the walls, words and head of `b` and counts that are no smaller.
+    static bool sameShape(const tape_formula &a, const tape_formula &b)
+    {
+        if (a.walls != b.walls || a.headCell != b.headCell || a.repeaters.size() != b.repeaters.size())
+            return false;
+        for (size_t i = 0; i < a.repeaters.size(); ++i)
+            if (a.repeaters[i].word != b.repeaters[i].word || a.repeaters[i].count < b.repeaters[i].count)
+                return false;
+        return true;
+    }
+
+    /// Runs one step, and then takes the head through the repeaters that it runs into.
+    static bool step(const turing_rule &rule, tape_formula &f, size_t &steps)
+    {
+        auto &cell = f.walls[f.headWall][f.headCell];
+        const auto &tr = rule[f.state, cell];
+        if (tr.toState < 0 || (size_t)tr.toState >= rule.numStates())
+            return false;
+        cell = tr.symbol;
+        f.state = tr.toState;
+        ++steps;
+        if (tr.direction == direction::right)
+        {
+            ++f.headCell;
+            while (f.headCell == f.walls[f.headWall].size())
+            {
+                if (f.headWall + 1 == f.walls.size())
+                {
+                    f.walls.back().push_back(0);
+                    break;
+                }
+                if (!cross(rule, f, direction::right, steps))
+                    return false;
+            }
+            return true;
+        }
+        if (f.headCell > 0)
+        {
+            --f.headCell;
+            return true;
+        }
+        // The head is before the first cell of its wall until it lands on a cell.
+        while (true)
+        {
+            if (f.headWall == 0)
+            {
+                f.walls.front().insert(f.walls.front().begin(), 0);
+                f.headCell = 0;
+                return true;
+            }
+            if (!cross(rule, f, direction::left, steps))
+                return false;
+            if (f.headCell != std::numeric_limits<size_t>::max())
+                return true;
+        }
+    }
+
+    /// Takes the head, which has just left its wall in direction `d`, through the next repeater by a shift rule: the
+    /// head carries the `k` cells of the wall nearest to the repeater across one copy of its word, leaving the copy
+    /// changed and the carried cells and state as they were, so every copy changes the same way. The smallest `k` that
+    /// works is used. If none does, the nearest copy is taken out of the repeater into the wall, which the proof can do
+    /// for any count because counts only have to be at least the ones in the formula. Returns false if the repeater
+    /// has count 0 then. Going left, the head is left before the first cell of its wall if it is empty, marked by
+    /// `headCell` being the maximum.
+    static bool cross(const turing_rule &rule, tape_formula &f, direction d, size_t &steps)
+    {
+        const size_t i = f.headWall;
+        auto &wall = f.walls[i];
+        auto &r = f.repeaters[d == direction::right ? i : i - 1];
+        const size_t n = r.word.size();
+        for (size_t k = 0; k <= std::min(maxCarried, wall.size()); ++k)
+        {
+            // The carried cells, then a copy, going right, and a copy, then the carried cells, going left
+            std::vector<symbol_type> v;
+            if (d == direction::right)
+            {
+                v.assign(wall.end() - (ptrdiff_t)k, wall.end());
+                v.insert(v.end(), r.word.begin(), r.word.end());
+            }
+            else
+            {
+                v = r.word;
+                v.insert(v.end(), wall.begin(), wall.begin() + (ptrdiff_t)k);
+            }
+            if (!shift(rule, v, k, f.state, d, steps))
+                continue;
+            if (d == direction::right)
+            {
+                r.word.assign(v.begin(), v.begin() + (ptrdiff_t)n);
+                auto &next = f.walls[i + 1];
+                next.insert(next.begin(), v.begin() + (ptrdiff_t)n, v.end());
+                wall.resize(wall.size() - k);
+                f.headWall = i + 1;
+                f.headCell = k;
+            }
+            else
+            {
+                r.word.assign(v.begin() + (ptrdiff_t)k, v.end());
+                auto &previous = f.walls[i - 1];
+                previous.insert(previous.end(), v.begin(), v.begin() + (ptrdiff_t)k);
+                wall.erase(wall.begin(), wall.begin() + (ptrdiff_t)k);
+                f.headWall = i - 1;
+                f.headCell = previous.size() == k ? std::numeric_limits<size_t>::max() : previous.size() - k - 1;
+            }
+            return true;
+        }
+        if (r.count == 0)
+            return false;
+        --r.count;
+        if (d == direction::right)
+            wall.insert(wall.end(), r.word.begin(), r.word.end());
+        else
+        {
+            wall.insert(wall.begin(), r.word.begin(), r.word.end());
+            f.headCell = n - 1;
+        }
+        return true;
+    }
+
+    /// Runs the machine on `v`, the carried cells and a copy of a word in the order of `d`, with the head entering the
+    /// copy from the carried cells in `state`. The shift rule holds if the head leaves the copy on the other side in
+    /// `state`, without leaving the carried cells on their side, with the carried cells unchanged beyond it. Then `v`
+    /// is the changed copy with the carried cells on its other side.
+    static bool shift(const turing_rule &rule, std::vector<symbol_type> &v, size_t k, state_type state, direction d,
+                      size_t &steps)
+    {
+        const auto size = (int64_t)v.size();
+        const auto carried = std::vector<symbol_type>(d == direction::right ? v.begin() : v.end() - (ptrdiff_t)k,
+                                                      d == direction::right ? v.begin() + (ptrdiff_t)k : v.end());
+        auto w = v;
+        int64_t p = d == direction::right ? (int64_t)k : size - (int64_t)k - 1;
+        state_type s = state;
+        while (p >= 0 && p < size)
+        {
+            if (++steps > maxProofSteps)
+                return false;
+            const auto &tr = rule[s, w[p]];
+            if (tr.toState < 0 || (size_t)tr.toState >= rule.numStates())
+                return false;
+            w[p] = tr.symbol;
+            s = tr.toState;
+            p += tr.direction == direction::right ? 1 : -1;
+        }
+        if ((p == size) != (d == direction::right) || s != state)
+            return false;
+        // The carried cells must come out unchanged next to the side that the head leaves by.
+        const auto end = d == direction::right ? w.end() - (ptrdiff_t)k : w.begin();
+        if (!std::equal(carried.begin(), carried.end(), end))
+            return false;
+        v = std::move(w);
+        return true;
+    }
+};
+} // namespace turing
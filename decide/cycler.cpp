@@ -3,14 +3,24 @@
 
 #include "../pch.hpp"
 
+#include "brent_cycler.hpp"
 #include "tcycler.hpp"
 
 using namespace std;
 using namespace turing;
 
-void run(turing_rule rule, size_t numSteps, size_t initialPeriodBound, bool verbose)
+void run(turing_rule rule, size_t numSteps, size_t initialPeriodBound, bool brent, bool verbose)
 {
-    auto &&res = CyclerDecider(verbose).find(rule, numSteps, initialPeriodBound);
+    if (brent)
+    {
+        auto res = BrentCyclerDecider{}.find(TuringMachine{rule}, numSteps);
+        if (res.period == 0)
+            cout << "No period found\n";
+        else
+            cout << "(period, preperiod) = " << tuple{res.period, res.preperiod} << '\n';
+        return;
+    }
+    auto &&res = CyclerDecider(verbose).find(TuringMachine{rule}, numSteps, initialPeriodBound);
     if (res.period == 0)
         cout << "No period found\n";
     else
@@ -31,11 +41,13 @@ Options:
   -h, --help           Show this help message
   -v, --verbose        Show verbose output
   -p, --period <n>     The initial period bound (default: 10000)
+  -b, --brent          Use Brent's cycle detection, which needs no period bound
   -n, --num-steps <n>  The number of steps to run for (default: unbounded)
 )";
     const span args(argv, argc);
     turing_rule rule;
     bool verbose = false;
+    bool brent = false;
     size_t numSteps = std::numeric_limits<size_t>::max();
     size_t initialPeriodBound = 10000;
     for (int i = 1; i < argc; ++i)
@@ -47,6 +59,8 @@ Options:
         }
         if (strcmp(args[i], "-v") == 0 || strcmp(args[i], "--verbose") == 0)
             verbose = true;
+        else if (strcmp(args[i], "-b") == 0 || strcmp(args[i], "--brent") == 0)
+            brent = true;
         else if (strcmp(args[i], "-p") == 0 || strcmp(args[i], "--period") == 0)
             initialPeriodBound = parseNumber(args[++i]);
         else if (strcmp(args[i], "-n") == 0 || strcmp(args[i], "--num-steps") == 0)
@@ -71,5 +85,5 @@ Options:
         cout << help;
         return 0;
     }
-    printTiming(run, rule, numSteps, initialPeriodBound, verbose);
+    printTiming(run, rule, numSteps, initialPeriodBound, brent, verbose);
 }
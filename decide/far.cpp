@@ -0,0 +1,76 @@
+// Proves that a Turing machine never halts by finite automata reduction.
+
+#include "../pch.hpp"
+
+#include "far.hpp"
+
+using namespace std;
+using namespace turing;
+
+void run(const turing_rule &rule, size_t maxDfaStates, size_t maxNodes)
+{
+    const auto res = FarDecider{}.find(rule, maxDfaStates, maxNodes);
+    if (!res.found)
+        cout << "No DFA found in " << res.nodes << " partial DFAs\n";
+    else
+        cout << "Never halts: DFA " << res.dfa.str() << (res.mirrored ? " (mirrored)" : "") << " found in "
+             << res.nodes << " partial DFAs\n";
+}
+
+int main(int argc, char *argv[])
+{
+    constexpr string_view help =
+        R"(Finite automata reduction decider. Proves that a machine never halts with a
+DFA on the tape to the left of the head, or to the right of it if mirrored.
+
+Usage: ./run decide/far <TM>
+
+Arguments:
+  <TM>  The Turing machine
+
+Options:
+  -h, --help             Show this help message
+  -s, --dfa-states <n>   The maximum number of DFA states (default: 5)
+  -n, --max-nodes <n>    The number of partial DFAs to try (default: unbounded)
+
+Comments:
+  The DFA is printed like a machine, with the next state on each symbol for
+  each DFA state, like "01_21_22".
+)";
+    const span args(argv, argc);
+    turing_rule rule;
+    size_t maxDfaStates = 5;
+    size_t maxNodes = std::numeric_limits<size_t>::max();
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(args[i], "-h") == 0 || strcmp(args[i], "--help") == 0)
+        {
+            cout << help;
+            return 0;
+        }
+        if (strcmp(args[i], "-s") == 0 || strcmp(args[i], "--dfa-states") == 0)
+            maxDfaStates = parseNumber(args[++i]);
+        else if (strcmp(args[i], "-n") == 0 || strcmp(args[i], "--max-nodes") == 0)
+            maxNodes = parseNumber(args[++i]);
+        else if (rule.empty())
+        {
+            rule = turing_rule(args[i]);
+            if (rule.empty())
+            {
+                cerr << ansi::red << "Invalid TM: " << ansi::reset << args[i] << '\n' << help;
+                return 0;
+            }
+        }
+        else
+        {
+            cerr << ansi::red << "Unexpected argument: " << ansi::reset << args[i] << '\n' << help;
+            return 0;
+        }
+    }
+    if (rule.empty())
+    {
+        cout << help;
+        return 0;
+    }
+    printTiming(run, rule, maxDfaStates, maxNodes);
+}
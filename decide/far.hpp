@@ -0,0 +1,279 @@
+#pragma once
+
+#include <bit>
+#include <string>
+#include <vector>
+
+#include "../turing.hpp"
+
+namespace turing
+{
+/// A DFA that reads the tape to the left of the head from left to right. State 0 is the initial state, and it stays in
+/// state 0 on blanks, so that the blanks at the left end of the tape don't matter. A transition that is -1 is not
+/// decided yet.
+struct far_dfa
+{
+    size_t numSymbols = 0;
+    /// `next[q * numSymbols + s]` is the state after reading `s` in state `q`.
+    std::vector<int8_t> next;
+
+    [[nodiscard]] size_t numStates() const { return numSymbols == 0 ? 0 : next.size() / numSymbols; }
+
+    [[nodiscard]] int8_t operator[](size_t q, size_t s) const { return next[q * numSymbols + s]; }
+
+    /// The transitions of each state, in the style of machine codes, like "01_21_22".
+    [[nodiscard]] std::string str() const
+    {
+        std::string s;
+        for (size_t i = 0; i < next.size(); ++i)
+        {
+            if (i != 0 && i % numSymbols == 0)
+                s += '_';
+            s += next[i] < 0 ? '-' : (char)('0' + next[i]);
+        }
+        return s;
+    }
+};
+
+/// Finds the least tape language of a DFA, for finite automata reduction. A configuration is written as the tape left
+/// of the head, the state, and the tape from the head on. The language is that of the DFA on the left part, followed
+/// by an NFA on the rest, whose states are (DFA state, machine state) pairs that it enters on the state letter, and a
+/// sink ⊥ that accepts. A configuration is in the language if some number of blanks appended to it takes the NFA to ⊥.
+///
+/// The NFA transitions are the least ones such that the language contains every configuration that halts in one step
+/// and every configuration whose successor is in it. So the language contains every configuration that halts, and if
+/// it doesn't contain the initial one, the machine never halts. The constraints only grow with the DFA transitions, so
+/// a partial DFA whose language already contains the initial configuration can be discarded with all its completions.
+/// That makes the solver incremental: a search assigns the DFA transitions one by one, and backtracks by copying it.
+class FarSolver
+{
+  public:
+    /// The most NFA states, which are sets of bits.
+    static constexpr size_t maxNfaStates = 64;
+
+    /// A solver for DFAs of up to `dfaStates` states, none of whose transitions are decided yet except that state 0
+    /// stays in state 0 on blanks. Requires `dfaStates * rule.numStates() < maxNfaStates`.
+    FarSolver(const turing_rule &rule, size_t dfaStates)
+        : _rule(rule),
+          _dfa{.numSymbols = rule.numSymbols(), .next = std::vector<int8_t>(dfaStates * rule.numSymbols(), -1)},
+          _bottom(dfaStates * rule.numStates())
+    {
+        for (size_t s = 0; s < _rule.numSymbols(); ++s)
+            _nfa[s][_bottom] = bit(_bottom);
+        for (size_t f = 0; f < _rule.numStates(); ++f)
+            for (size_t r = 0; r < _rule.numSymbols(); ++r)
+                if (halts(_rule[f, r]))
+                    for (size_t q = 0; q < dfaStates; ++q)
+                        _nfa[r][node(q, f)] |= bit(_bottom);
+        _consistent = assign(0, 0, 0);
+    }
+
+    /// The DFA so far.
+    [[nodiscard]] const far_dfa &dfa() const { return _dfa; }
+
+    /// Whether the language of the DFA so far leaves out the initial configuration.
+    [[nodiscard]] bool consistent() const { return _consistent; }
+
+    /// Decides that the DFA goes from state `q` to state `to` on `s`, and extends the NFA. Returns whether the language
+    /// still leaves out the initial configuration. The transition must not be decided yet.
+    bool assign(size_t q, size_t s, size_t to)
+    {
+        _dfa.next[q * _dfa.numSymbols + s] = (int8_t)to;
+        if (!_consistent)
+            return false;
+        for (size_t f = 0; f < _rule.numStates(); ++f)
+            for (size_t r = 0; r < _rule.numSymbols(); ++r)
+            {
+                const auto &tr = _rule[f, r];
+                if (!halts(tr) && tr.direction == direction::right && tr.symbol == s)
+                    _nfa[r][node(q, f)] |= bit(node(to, tr.toState));
+            }
+        saturate();
+        return _consistent = !accepts(node(0, 0));
+    }
+
+    /// Whether each state that the DFA reaches from state 0 has all its transitions decided.
+    [[nodiscard]] bool complete() const
+    {
+        uint64_t seen = 1;
+        std::vector<size_t> stack{0};
+        while (!stack.empty())
+        {
+            const size_t q = stack.back();
+            stack.pop_back();
+            for (size_t s = 0; s < _dfa.numSymbols; ++s)
+            {
+                const auto to = _dfa[q, s];
+                if (to < 0)
+                    return false;
+                if ((seen & bit(to)) == 0)
+                {
+                    seen |= bit(to);
+                    stack.push_back(to);
+                }
+            }
+        }
+        return true;
+    }
+
+  private:
+    static uint64_t bit(size_t i) { return uint64_t{1} << i; }
+
+    [[nodiscard]] bool halts(const transition &tr) const
+    {
+        return tr.toState < 0 || (size_t)tr.toState >= _rule.numStates();
+    }
+
+    [[nodiscard]] size_t node(size_t q, size_t f) const { return q * _rule.numStates() + f; }
+
+    /// The NFA states reached from the states in `from` on `s`.
+    [[nodiscard]] uint64_t image(uint64_t from, size_t s) const
+    {
+        uint64_t to = 0;
+        for (; from != 0; from &= from - 1)
+            to |= _nfa[s][std::countr_zero(from)];
+        return to;
+    }
+
+    /// Extends the NFA until the left moves hold: for a move from (f, r) to (w, L, t), each DFA state q and symbol b,
+    /// the configurations `u t b w v` and `u b f r v` with u in DFA state q, the second reached on the right of the
+    /// first.
+    void saturate()
+    {
+        for (bool changed = true; changed;)
+        {
+            changed = false;
+            for (size_t f = 0; f < _rule.numStates(); ++f)
+                for (size_t r = 0; r < _rule.numSymbols(); ++r)
+                {
+                    const auto &tr = _rule[f, r];
+                    if (halts(tr) || tr.direction != direction::left)
+                        continue;
+                    for (size_t q = 0; q < _dfa.numStates(); ++q)
+                        for (size_t b = 0; b < _dfa.numSymbols; ++b)
+                        {
+                            const auto qb = _dfa[q, b];
+                            if (qb < 0)
+                                continue;
+                            const uint64_t to = image(_nfa[b][node(q, tr.toState)], tr.symbol);
+                            auto &row = _nfa[r][node(qb, f)];
+                            if ((row | to) != row)
+                            {
+                                row |= to;
+                                changed = true;
+                            }
+                        }
+                }
+        }
+    }
+
+    /// Whether some number of blanks takes the NFA from state `i` to ⊥.
+    [[nodiscard]] bool accepts(size_t i) const
+    {
+        uint64_t reached = bit(i);
+        for (uint64_t last = 0; reached != last;)
+        {
+            last = reached;
+            reached |= image(reached, 0);
+        }
+        return (reached & bit(_bottom)) != 0;
+    }
+
+    turing_rule _rule;
+    far_dfa _dfa;
+    size_t _bottom;
+    /// `_nfa[s][i]` is the set of states that the NFA goes to from state i on s.
+    std::array<std::array<uint64_t, maxNfaStates>, maxSymbols> _nfa{};
+    bool _consistent = true;
+};
+
+struct far_result
+{
+    bool found = false;
+    /// Whether the DFA is of the mirrored machine, so it reads the tape to the right of the head from right to left.
+    bool mirrored = false;
+    far_dfa dfa;
+    /// The number of partial DFAs that the search tried.
+    size_t nodes = 0;
+};
+
+/// Decides that machines never halt by finite automata reduction: it searches for a DFA whose least tape language, as
+/// `FarSolver` finds it, leaves out the initial configuration. The search tries the partial DFAs with states numbered
+/// in the order in which they are first reached, assigning transitions in order of state and symbol, for the machine
+/// and for its mirror image. It tries each number of DFA states in turn, so the DFA that it finds is a smallest one.
+class FarDecider
+{
+  public:
+    /// Searches the DFAs of up to `maxDfaStates` states, and gives up after trying `maxNodes` partial DFAs.
+    [[nodiscard]] far_result find(const turing_rule &rule, size_t maxDfaStates,
+                                  size_t maxNodes = std::numeric_limits<size_t>::max()) const
+    {
+        far_result res;
+        maxDfaStates = std::min(maxDfaStates, (FarSolver::maxNfaStates - 1) / std::max(rule.numStates(), 1UZ));
+        const std::array<turing_rule, 2> rules{rule, mirror(rule)};
+        for (size_t n = 1; n <= maxDfaStates; ++n)
+            for (const bool mirrored : {false, true})
+            {
+                res.mirrored = mirrored;
+                FarSolver solver(rules[mirrored], n);
+                if (search(solver, 1, 1, res, maxNodes))
+                {
+                    res.found = true;
+                    return res;
+                }
+            }
+        return res;
+    }
+
+    /// Whether the DFA proves that the machine never halts. This verifies a result of `find`.
+    [[nodiscard]] static bool check(const turing_rule &rule, const far_dfa &dfa, bool mirrored)
+    {
+        if (rule.empty() || dfa.numSymbols != rule.numSymbols() || dfa.numStates() == 0 ||
+            dfa.numStates() * rule.numStates() >= FarSolver::maxNfaStates || dfa[0, 0] != 0)
+            return false;
+        FarSolver solver(mirrored ? mirror(rule) : rule, dfa.numStates());
+        for (size_t q = 0; q < dfa.numStates(); ++q)
+            for (size_t s = 0; s < dfa.numSymbols; ++s)
+            {
+                const auto to = dfa[q, s];
+                if ((q != 0 || s != 0) && to >= 0 && (size_t)to < dfa.numStates() && !solver.assign(q, s, to))
+                    return false;
+            }
+        return solver.consistent() && solver.complete();
+    }
+
+    /// The machine with its moves mirrored.
+    [[nodiscard]] static turing_rule mirror(turing_rule rule)
+    {
+        for (size_t i = 0; i < rule.numStates(); ++i)
+            for (size_t j = 0; j < rule.numSymbols(); ++j)
+                rule[i, j].direction = rule[i, j].direction == direction::left ? direction::right : direction::left;
+        return rule;
+    }
+
+  private:
+    /// Assigns the transitions from the `i`th one on, where `used` states are reached so far. A state that is not
+    /// reached when its transitions come up is never reached, so the DFA is complete.
+    static bool search(FarSolver &solver, size_t i, size_t used, far_result &res, size_t maxNodes)
+    {
+        const auto &dfa = solver.dfa();
+        if (i == dfa.next.size() || i / dfa.numSymbols >= used)
+        {
+            res.dfa = dfa;
+            res.dfa.next.resize(used * dfa.numSymbols);
+            return true;
+        }
+        for (size_t to = 0; to <= std::min(used, dfa.numStates() - 1); ++to)
+        {
+            if (res.nodes == maxNodes)
+                return false;
+            ++res.nodes;
+            auto next = solver;
+            if (next.assign(i / dfa.numSymbols, i % dfa.numSymbols, to) &&
+                search(next, i + 1, std::max(used, to + 1), res, maxNodes))
+                return true;
+        }
+        return false;
+    }
+};
+} // namespace turing
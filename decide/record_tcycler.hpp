@@ -0,0 +1,200 @@
+#pragma once
+
+#include <boost/unordered/unordered_flat_map.hpp>
+
+#include "tcycler.hpp"
+
+namespace turing
+{
+/// Detects translated cyclers in one forward pass. `TranslatedCyclerDecider` compares each record, a step where the
+/// tape expands, to a single earlier one, and starts over from a new one with a larger period bound when the bound runs
+/// out, so it needs several times the period to find a long one. This decider instead indexes the records of each side
+/// by their state, the steps since the previous record on the side and the cells behind the edge, along with a snapshot
+/// of the cells behind the edge. A record whose key was seen before is compared to the last few with that key in state
+/// and in the span that the head visited in between, exactly as `TranslatedCyclerDecider` compares them, so a cycle is
+/// found one period after both records are in it, as long as its key comes up at most `recordsPerKey` times a period.
+class RecordTranslatedCyclerDecider
+{
+  public:
+    /// Number of cells behind the edge that are hashed into the key of a record.
+    static constexpr int64_t keyWidth = 8;
+    /// Number of cells behind the edge in the snapshot of a record. If the head went deeper between two records, the
+    /// period that they propose is confirmed one period later instead.
+    static constexpr int64_t snapshotWidth = 64;
+    /// Number of the last records with a key that a new record with the key is compared to. A key can come up more
+    /// than once in a period when the cells that differ are deeper than `keyWidth`.
+    static constexpr size_t recordsPerKey = 4;
+
+    /// Finds the period and offset of a translated cycle within `maxSteps` steps. The returned preperiod is only an
+    /// upper bound, and the last machine is the given one. Returns period 0 if the machine halts or no cycle is found.
+    template <typename Machine = TuringMachine>
+    [[nodiscard]] cycler_result<Machine> findPeriodOnly(Machine machine, size_t maxSteps) const
+    {
+        const size_t startSteps = machine.steps();
+        auto m = machine;
+        const transition_table table{m.rule()};
+        std::array<side_records, 2> sides;
+        sides[0].last = sides[1].last = startSteps;
+        // The lowest head position since the last record on the right, and the highest since the last on the left
+        int64_t lh = m.head();
+        int64_t hh = m.head();
+        // A proposed period that is confirmed at the record where it ends, if its span didn't fit in the snapshot
+        Machine anchor;
+        size_t anchorRecord = 0;
+        size_t due = 0;
+        bool expanded = false;
+        const auto untilExpanded = [&](const step_info &info) {
+            lh = std::min(lh, info.head);
+            hh = std::max(hh, info.head);
+            return expanded = info.tapeExpanded;
+        };
+        const auto found = [&](const size_t step, const int64_t head) {
+            return cycler_result<Machine>{.period = m.steps() - step,
+                                          .preperiod = step,
+                                          .offset = m.head() - head,
+                                          .steps = m.steps() - startSteps,
+                                          .lastMachine = std::move(machine)};
+        };
+        while (m.steps() - startSteps < maxSteps)
+        {
+            expanded = false;
+            m.runUntil(table, untilExpanded, maxSteps - (m.steps() - startSteps));
+            if (!expanded)
+                break;
+            // Positions are mirrored on the left, so that the edge is the highest position on both sides.
+            const bool right = m.head() > 0;
+            const auto x = [&](int64_t position) { return right ? position : -position; };
+            auto &side = sides[right];
+            side.push(x(right ? lh : hh));
+            (right ? lh : hh) = m.head();
+
+            if (due != 0 && m.steps() >= due)
+            {
+                if (m.steps() == due && (anchor.head() > 0) == right && m.state() == anchor.state())
+                {
+                    const auto low = x(side.lowestSince(anchorRecord + 1));
+                    const auto l = right ? low - anchor.head() : 0;
+                    const auto h = right ? 0 : low - anchor.head();
+                    if (spansEqual(anchor.tape(), m.tape(), l, h))
+                        return found(anchor.steps(), anchor.head());
+                }
+                due = 0;
+            }
+
+            const size_t sinceLast = m.steps() - side.last;
+            side.last = m.steps();
+            auto &entries = side.index[key(m, right, sinceLast)];
+            // The most recent records first, so that the shortest period is found
+            for (size_t i = 0; i < std::min(entries.count, recordsPerKey); ++i)
+            {
+                const auto &e = entries.records[(entries.count - 1 - i) % recordsPerKey];
+                if (e.state != m.state())
+                    continue;
+                const int64_t depth = x(e.head) - side.lowestSince(e.record + 1);
+                if (depth <= snapshotWidth)
+                {
+                    bool equal = true;
+                    for (int64_t j = 1; j <= depth && equal; ++j)
+                        equal = e.cells[j - 1] == m.tape()[m.head() - x(j)];
+                    if (equal)
+                        return found(e.step, e.head);
+                }
+                else if (due == 0)
+                {
+                    anchor = m;
+                    anchorRecord = side.count - 1;
+                    due = 2 * m.steps() - e.step;
+                }
+            }
+            auto &e = entries.records[entries.count++ % recordsPerKey];
+            e.step = m.steps();
+            e.record = side.count - 1;
+            e.head = m.head();
+            e.state = m.state();
+            for (int64_t j = 1; j <= snapshotWidth; ++j)
+                e.cells[j - 1] = m.tape()[m.head() - x(j)];
+        }
+        return {.period = 0,
+                .preperiod = 0,
+                .offset = 0,
+                .steps = m.steps() - startSteps,
+                .lastMachine = std::move(machine)};
+    }
+
+    /// Finds the period, exact preperiod and offset of a translated cycle within `maxSteps` steps. The preperiod is
+    /// found by a binary search like that of `CyclerDecider::find`.
+    template <typename Machine = TuringMachine>
+    [[nodiscard]] cycler_result<Machine> find(Machine machine, size_t maxSteps) const
+    {
+        auto res = findPeriodOnly(std::move(machine), maxSteps);
+        if (res.period == 0)
+            return res;
+        const auto &m = res.lastMachine;
+        res.preperiod = findPreperiod(m, res.period, m.steps(), res.preperiod);
+        // If preperiod was the minimum, restart binary search from 0.
+        if (res.preperiod == m.steps() && m.steps() > 0)
+            res.preperiod = findPreperiod(m, res.period, 0, res.preperiod);
+        return res;
+    }
+
+  private:
+    /// A record with a key.
+    struct index_entry
+    {
+        size_t step = 0;
+        /// The number of the record on its side.
+        size_t record = 0;
+        int64_t head = 0;
+        state_type state = 0;
+        /// The cells behind the edge, nearest first.
+        std::array<symbol_type, snapshotWidth> cells{};
+    };
+
+    /// The last records with a key, as a ring buffer.
+    struct key_records
+    {
+        std::array<index_entry, recordsPerKey> records{};
+        /// The number of records with the key so far.
+        size_t count = 0;
+    };
+
+    /// The records of one side, in mirrored positions on the left.
+    struct side_records
+    {
+        boost::unordered_flat_map<uint64_t, key_records> index;
+        /// The number of records, and the step of the last one.
+        size_t count = 0;
+        size_t last = 0;
+        /// Suffix minima of the lowest head positions between consecutive records: (record, lowest position since the
+        /// one before it), kept only where that position is higher than for all earlier records.
+        std::vector<std::pair<size_t, int64_t>> lowest;
+
+        /// Adds a record, with the lowest head position since the previous one.
+        void push(int64_t low)
+        {
+            while (!lowest.empty() && lowest.back().second >= low)
+                lowest.pop_back();
+            lowest.emplace_back(count++, low);
+        }
+
+        /// The lowest head position since the record before the given one, which must be less than `count`.
+        [[nodiscard]] int64_t lowestSince(size_t record) const
+        {
+            return std::ranges::lower_bound(lowest, record, {}, &std::pair<size_t, int64_t>::first)->second;
+        }
+    };
+
+    /// The key of a record: its state and side, the steps since the previous record on its side, and the cells behind
+    /// the head.
+    template <typename Machine> static uint64_t key(const Machine &m, bool right, size_t sinceLast)
+    {
+        uint64_t h = 0xcbf2'9ce4'8422'2325;
+        const auto mix = [&](uint64_t x) { h = (h ^ x) * 0x100'0000'01b3; };
+        mix((uint64_t)m.state() << 1 | (uint64_t)right);
+        mix(sinceLast);
+        for (int64_t i = 1; i <= keyWidth; ++i)
+            mix(m.tape()[right ? m.head() - i : m.head() + i]);
+        return h;
+    }
+};
+} // namespace turing
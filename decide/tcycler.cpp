@@ -3,18 +3,23 @@
 
 #include "../pch.hpp"
 
+#include "record_tcycler.hpp"
 #include "tcycler.hpp"
 
 using namespace std;
 using namespace turing;
 
-void run(turing_rule rule, size_t numSteps, size_t initialPeriodBound, bool fast, bool verbose)
+void run(turing_rule rule, size_t numSteps, size_t initialPeriodBound, bool fast, bool records, bool verbose)
 {
+    const TuringMachine m{rule};
     cycler_result res;
-    if (fast)
-        res = TranslatedCyclerDecider{verbose}.findPeriodOnly(rule, numSteps, initialPeriodBound);
+    if (records)
+        res = fast ? RecordTranslatedCyclerDecider{}.findPeriodOnly(m, numSteps)
+                   : RecordTranslatedCyclerDecider{}.find(m, numSteps);
+    else if (fast)
+        res = TranslatedCyclerDecider{verbose}.findPeriodOnly(m, numSteps, initialPeriodBound);
     else
-        res = TranslatedCyclerDecider(verbose).find(rule, numSteps, initialPeriodBound);
+        res = TranslatedCyclerDecider(verbose).find(m, numSteps, initialPeriodBound);
     if (res.period == 0)
         cout << "No period found\n";
     else
@@ -36,11 +41,13 @@ Options:
   -f, --fast           Don't calculate exact preperiod
   -n, --num-steps <n>  The number of steps to run for (default: unbounded)
   -p, --period <n>     The initial period bound (default: 10000)
+  -r, --records        Index the records by their surroundings, which needs no period bound
   -v, --verbose        Show verbose output
 )";
     const span args(argv, argc);
     turing_rule rule;
     bool fast = false;
+    bool records = false;
     bool verbose = false;
     size_t numSteps = std::numeric_limits<size_t>::max();
     size_t initialPeriodBound = 10000;
@@ -53,6 +60,8 @@ Options:
         }
         if (strcmp(args[i], "-f") == 0 || strcmp(args[i], "--fast") == 0)
             fast = true;
+        else if (strcmp(args[i], "-r") == 0 || strcmp(args[i], "--records") == 0)
+            records = true;
         else if (strcmp(args[i], "-v") == 0 || strcmp(args[i], "--verbose") == 0)
             verbose = true;
         else if (strcmp(args[i], "-p") == 0 || strcmp(args[i], "--period") == 0)
@@ -79,5 +88,5 @@ Options:
         cout << help;
         return 0;
     }
-    printTiming(run, rule, numSteps, initialPeriodBound, fast, verbose);
+    printTiming(run, rule, numSteps, initialPeriodBound, fast, records, verbose);
 }
@@ -7,7 +7,8 @@ namespace turing
 constexpr double periodGrowthRatio = 1.1;
 
 /// Checks period of before and after.
-inline bool checkForPeriod(const TuringMachine &before, const TuringMachine &after, int64_t start, int64_t stop)
+template <typename Machine>
+bool checkForPeriod(const Machine &before, const Machine &after, int64_t start, int64_t stop)
 {
     if (before.state() != after.state())
         return false;
@@ -17,7 +18,7 @@ inline bool checkForPeriod(const TuringMachine &before, const TuringMachine &aft
 }
 
 /// Returns whether the machine (at its current state) is purely periodic with the given period.
-inline bool isPeriodic(TuringMachine m, size_t period)
+template <typename Machine> bool isPeriodic(Machine m, size_t period)
 {
     auto start = m;
     int64_t lh = start.head();
@@ -33,7 +34,8 @@ inline bool isPeriodic(TuringMachine m, size_t period)
 }
 
 /// Finds the preperiod. Requires exact period to be known.
-[[nodiscard]] inline size_t findPreperiod(TuringMachine m, size_t period, size_t low, size_t high, bool verbose = false)
+template <typename Machine>
+[[nodiscard]] size_t findPreperiod(Machine m, size_t period, size_t low, size_t high, bool verbose = false)
 {
     assert(low <= high);
     // Binary search
@@ -66,13 +68,33 @@ inline bool isPeriodic(TuringMachine m, size_t period)
     return high;
 }
 
-struct cycler_result
+template <typename Machine = TuringMachine> struct cycler_result
 {
     size_t period = 0;
     size_t preperiod = 0;
     int64_t offset = 0;
+    /// Number of steps that the period search simulated.
+    size_t steps = 0;
     /// Last known machine that didn't yield a period.
-    TuringMachine lastMachine;
+    Machine lastMachine;
+};
+
+/// A period search in progress. Extending a session to a step budget gives the same result as a fresh search with
+/// that budget, without simulating again the steps that were already taken, so a cheap check can be escalated to an
+/// expensive one.
+template <typename Machine = TuringMachine> struct cycler_session
+{
+    Machine machine;
+    size_t startPeriodBound = 0;
+    size_t periodBound = 0;
+    /// The period bound of the previous round, used by the translated cycler decider.
+    size_t prevPeriodBound = 0;
+    /// The machine at the start of the previous round.
+    Machine prev2;
+    size_t startSteps = 0;
+    /// Whether the search is over, because it found a period or the machine halted.
+    bool done = false;
+    cycler_result<Machine> result;
 };
 
 class CyclerDecider
@@ -82,50 +104,84 @@ class CyclerDecider
 
     [[nodiscard]] constexpr bool verbose() const { return _verbose; }
 
-    [[nodiscard]]
-    cycler_result findPeriodOnly(TuringMachine machine, size_t maxSteps, size_t startPeriodBound = 100) const
+    /// Starts a period search, which `extend` runs.
+    template <typename Machine = TuringMachine>
+    [[nodiscard]] static cycler_session<Machine> session(Machine machine, size_t startPeriodBound = 100)
+    {
+        const size_t startSteps = machine.steps();
+        Machine prev2 = machine;
+        return {.machine = std::move(machine),
+                .startPeriodBound = startPeriodBound,
+                .periodBound = startPeriodBound,
+                .prev2 = std::move(prev2),
+                .startSteps = startSteps,
+                .done = false,
+                .result = {}};
+    }
+
+    /// Continues the search of the session until it finds a period or the machine has taken `maxSteps` steps since
+    /// the start of the session.
+    template <typename Machine>
+    const cycler_result<Machine> &extend(cycler_session<Machine> &s, size_t maxSteps) const
     {
-        size_t periodBound = startPeriodBound;
-        TuringMachine prev2 = machine;
-        maxSteps += machine.steps();
-        while (machine.steps() <= maxSteps)
+        auto &machine = s.machine;
+        maxSteps += s.startSteps;
+        while (!s.done && machine.steps() <= maxSteps)
         {
             if (_verbose)
                 std::cout << machine.steps() << " | " << machine.prettyStr() << '\n';
-            const TuringMachine prev = machine;
+            const Machine prev = machine;
             int64_t lh = prev.head();
             int64_t hh = prev.head();
-            for (size_t i = 1; i <= periodBound; ++i)
+            for (size_t i = 1; i <= s.periodBound; ++i)
             {
                 machine.step();
                 lh = std::min(lh, machine.head());
                 hh = std::max(hh, machine.head());
                 if (machine.head() == prev.head() && checkForPeriod(prev, machine, lh, hh))
                 {
-                    TuringMachine lastMachine =
-                        i <= startPeriodBound ? std::move(prev2) : TuringMachine{machine.rule()};
-                    return {.period = i,
-                            .preperiod = machine.steps() - i,
-                            .offset = machine.head() - prev.head(),
-                            .lastMachine = std::move(lastMachine)};
+                    Machine lastMachine = i <= s.startPeriodBound ? std::move(s.prev2) : Machine{machine.rule()};
+                    s.done = true;
+                    s.result = {.period = i,
+                                .preperiod = machine.steps() - i,
+                                .offset = machine.head() - prev.head(),
+                                .steps = 0,
+                                .lastMachine = std::move(lastMachine)};
+                    break;
                 }
             }
-            periodBound = std::max(periodBound + 1, (size_t)(periodBound * periodGrowthRatio));
-            prev2 = prev;
+            if (s.done)
+                break;
+            s.periodBound = std::max(s.periodBound + 1, (size_t)(s.periodBound * periodGrowthRatio));
+            s.prev2 = prev;
         }
-        return {};
+        s.result.steps = machine.steps() - s.startSteps;
+        return s.result;
+    }
+
+    template <typename Machine = TuringMachine>
+    [[nodiscard]] cycler_result<Machine> findPeriodOnly(Machine machine, size_t maxSteps,
+                                                        size_t startPeriodBound = 100) const
+    {
+        auto s = session(std::move(machine), startPeriodBound);
+        extend(s, maxSteps);
+        return std::move(s.result);
     }
 
     /// The main period detection function. Returns (period, preperiod, offset).
-    template <typename Self>
-    [[nodiscard]] cycler_result find(this const Self &self, TuringMachine machine, size_t maxSteps,
-                                     size_t startPeriodBound = 100)
+    template <typename Self, typename Machine = TuringMachine>
+    [[nodiscard]] cycler_result<Machine> find(this const Self &self, Machine machine, size_t maxSteps,
+                                              size_t startPeriodBound = 100)
     {
         auto res = self.findPeriodOnly(machine, maxSteps, startPeriodBound);
         if (res.period == 0)
         {
             // No period found.
-            return {.period = 0UZ, .preperiod = 0UZ, .offset = 0LL, .lastMachine = std::move(machine)};
+            return {.period = 0UZ,
+                    .preperiod = 0UZ,
+                    .offset = 0LL,
+                    .steps = res.steps,
+                    .lastMachine = std::move(machine)};
         }
         if (self._verbose)
             std::cout << "period = " << res.period << ", offset = " << res.offset << '\n';
@@ -136,7 +192,7 @@ class CyclerDecider
         // If preperiod was the minimum, restart binary search from 0.
         if (preperiod == m.steps())
             preperiod = findPreperiod(m, res.period, 0, preperiod, self._verbose);
-        return {res.period, preperiod, res.offset, std::move(machine)};
+        return {res.period, preperiod, res.offset, res.steps, std::move(machine)};
     }
 
   private:
@@ -149,46 +205,59 @@ class TranslatedCyclerDecider : public CyclerDecider
   public:
     constexpr TranslatedCyclerDecider(bool verbose = false) : CyclerDecider(verbose) {}
 
-    /// Finds a period for the given Turing machine rule code with the given period bound. The returned preperiod is
-    /// only an upper bound.
-    [[nodiscard]]
-    cycler_result findPeriodOnly(TuringMachine machine, size_t maxSteps, size_t startPeriodBound = 1000) const
+    /// Starts a search for a translated cycle, which `extend` runs.
+    template <typename Machine = TuringMachine>
+    [[nodiscard]] static cycler_session<Machine> session(Machine machine, size_t startPeriodBound = 1000)
+    {
+        return CyclerDecider::session(std::move(machine), startPeriodBound);
+    }
+
+    /// Continues the search of the session until it finds a period, the machine halts, or the machine has taken
+    /// `maxSteps` steps since the start of the session.
+    template <typename Machine>
+    const cycler_result<Machine> &extend(cycler_session<Machine> &s, size_t maxSteps) const
     {
-        size_t periodBound = startPeriodBound;
-        size_t prevPeriodBound = 0;
-        TuringMachine prev2 = machine;
-        maxSteps += machine.steps();
-        while (machine.steps() <= maxSteps)
+        auto &machine = s.machine;
+        maxSteps += s.startSteps;
+        while (!s.done && machine.steps() <= maxSteps)
         {
-            TuringMachine prev;
+            Machine prev;
             int expandDir = 0;
             // Grab edge tape
-            for (size_t i = 0; i < periodBound; ++i)
+            for (size_t i = 0; i < s.periodBound; ++i)
             {
                 auto res = machine.step();
                 if (!res.success)
-                    return {};
+                {
+                    s.done = true;
+                    break;
+                }
                 if (res.tapeExpanded)
                 {
                     prev = machine;
                     expandDir = machine.head() < 0 ? -1 : 1;
                     if (verbose())
-                        std::cout << "period bound = " << periodBound << " | " << machine.steps() << " | "
+                        std::cout << "period bound = " << s.periodBound << " | " << machine.steps() << " | "
                                   << machine.prettyStr() << '\n';
                     break;
                 }
             }
+            if (s.done)
+                break;
             // If no edge tape, just continue
             if (expandDir == 0)
                 continue;
             // Now try to find a period
             int64_t lh = prev.head();
             int64_t hh = prev.head();
-            for (size_t i = 1; i <= periodBound; ++i)
+            for (size_t i = 1; i <= s.periodBound; ++i)
             {
                 auto res = machine.step();
                 if (!res.success)
-                    return {};
+                {
+                    s.done = true;
+                    break;
+                }
                 lh = std::min(lh, machine.head());
                 hh = std::max(hh, machine.head());
                 if (res.tapeExpanded && machine.state() == prev.state())
@@ -205,20 +274,36 @@ class TranslatedCyclerDecider : public CyclerDecider
                             std::cout << ansi::green << ansi::bold << "[found] " << ansi::reset << machine.steps()
                                       << " | " << machine.prettyStr() << '\n';
                         // i = period.
-                        TuringMachine lastMachine =
-                            prevPeriodBound >= i ? std::move(prev2) : TuringMachine{machine.rule()};
-                        return {.period = i,
-                                .preperiod = machine.steps() - i,
-                                .offset = machine.head() - prev.head(),
-                                .lastMachine = std::move(lastMachine)};
+                        Machine lastMachine = s.prevPeriodBound >= i ? std::move(s.prev2) : Machine{machine.rule()};
+                        s.done = true;
+                        s.result = {.period = i,
+                                    .preperiod = machine.steps() - i,
+                                    .offset = machine.head() - prev.head(),
+                                    .steps = 0,
+                                    .lastMachine = std::move(lastMachine)};
+                        break;
                     }
                 }
             }
-            prevPeriodBound = periodBound;
-            periodBound = std::max(periodBound + 1, (size_t)(periodBound * periodGrowthRatio));
-            prev2 = prev;
+            if (s.done)
+                break;
+            s.prevPeriodBound = s.periodBound;
+            s.periodBound = std::max(s.periodBound + 1, (size_t)(s.periodBound * periodGrowthRatio));
+            s.prev2 = prev;
         }
-        return {};
+        s.result.steps = machine.steps() - s.startSteps;
+        return s.result;
+    }
+
+    /// Finds a period for the given Turing machine rule code with the given period bound. The returned preperiod is
+    /// only an upper bound.
+    template <typename Machine = TuringMachine>
+    [[nodiscard]] cycler_result<Machine> findPeriodOnly(Machine machine, size_t maxSteps,
+                                                        size_t startPeriodBound = 1000) const
+    {
+        auto s = session(std::move(machine), startPeriodBound);
+        extend(s, maxSteps);
+        return std::move(s.result);
     }
 };
 } // namespace turing
@@ -0,0 +1,337 @@
+#pragma once
+
+#include "../turing.hpp"
+
+#if __has_include(<dlfcn.h>)
+#define TURING_COMPILED_ENGINE
+
+#include <array>
+#include <charconv>
+#include <cstdlib>
+#include <dlfcn.h>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <unistd.h>
+
+namespace turing
+{
+/// The state shared between `CompiledTuringMachine` and its generated code. `data[lo..hi]` is the visited part of the
+/// tape, and `pos` is the head, all as indices into `data`.
+struct compiled_tape
+{
+    symbol_type *data;
+    int64_t size;
+    int64_t pos;
+    int64_t lo;
+    int64_t hi;
+    uint64_t steps;
+    int32_t state;
+};
+
+/// The version of the generated code and of the layout of `compiled_tape`. Bump it when either changes, so that shared
+/// objects compiled before are not loaded from the cache.
+constexpr uint32_t compiledAbiVersion = 1;
+
+/// Options for compiling Turing machines to native code.
+struct compile_options
+{
+    /// The C++ compiler. Defaults to `$TURING_CXX`, or clang++ if that is unset.
+    std::string compiler = defaultCompiler();
+    std::string flags = "-O2 -march=native";
+    /// Where to cache generated sources and shared objects. Defaults to `$TURING_CACHE_DIR`, or `turing-compiled`
+    /// in the temporary directory if that is unset.
+    std::filesystem::path cacheDir = defaultCacheDir();
+    bool verbose = false;
+
+    static std::string defaultCompiler()
+    {
+        const char *s = std::getenv("TURING_CXX");
+        return s != nullptr ? s : "clang++";
+    }
+
+    static std::filesystem::path defaultCacheDir()
+    {
+        const char *s = std::getenv("TURING_CACHE_DIR");
+        return s != nullptr ? std::filesystem::path(s) : std::filesystem::temp_directory_path() / "turing-compiled";
+    }
+
+    /// A hash of everything besides the rule that the shared object depends on, in hexadecimal: the compiler, the
+    /// flags and `compiledAbiVersion`, and the host name if the flags target the native CPU, since a cache directory
+    /// may be shared between hosts.
+    [[nodiscard]] std::string cacheKey() const
+    {
+        uint64_t h = 0xcbf2'9ce4'8422'2325;
+        const auto mix = [&](std::string_view s) {
+            for (const char ch : s)
+                h = (h ^ (uint8_t)ch) * 0x100'0000'01b3;
+            h = (h ^ 0xff) * 0x100'0000'01b3;
+        };
+        mix(compiler);
+        mix(flags);
+        mix(std::to_string(compiledAbiVersion));
+        if (flags.find("native") != std::string::npos)
+        {
+            std::array<char, 256> host{};
+            gethostname(host.data(), host.size() - 1);
+            mix(host.data());
+        }
+        std::array<char, 16> hex{};
+        return {hex.data(), std::to_chars(hex.data(), hex.data() + hex.size(), h, 16).ptr};
+    }
+};
+
+/// Generates C++ source code for a Turing machine. The code exports one function,
+/// `extern "C" void turing_run(compiled_tape *t, uint64_t maxSteps)`, which runs the machine until it halts, reaches
+/// `maxSteps` steps, or moves off the end of `t->data`. Each state is a label, and each transition writes, moves and
+/// jumps straight to the label of the next state.
+inline std::string generateSource(const turing_rule &rule)
+{
+    std::ostringstream o;
+    const auto label = [](size_t i) { return (char)('A' + i); };
+    o << "// " << rule.str() << R"(
+#include <cstdint>
+
+struct compiled_tape
+{
+    uint8_t *data;
+    int64_t size;
+    int64_t pos;
+    int64_t lo;
+    int64_t hi;
+    uint64_t steps;
+    int32_t state;
+};
+
+extern "C" void turing_run(compiled_tape *t, uint64_t maxSteps)
+{
+    uint8_t *const d = t->data;
+    const int64_t size = t->size;
+    int64_t p = t->pos;
+    int64_t lo = t->lo;
+    int64_t hi = t->hi;
+    uint64_t steps = t->steps;
+    int32_t s = t->state;
+    switch (s)
+    {
+)";
+    for (size_t i = 0; i < rule.numStates(); ++i)
+        o << "    case " << i << ": goto " << label(i) << ";\n";
+    o << "    default: return;\n    }\n";
+    for (size_t i = 0; i < rule.numStates(); ++i)
+    {
+        o << label(i) << ":\n    if (steps == maxSteps) { s = " << i << "; goto done; }\n    switch (d[p])\n    {\n";
+        for (size_t j = 0; j < rule.numSymbols(); ++j)
+        {
+            const auto &tr = rule[i, j];
+            const bool halts = tr.toState < 0 || (size_t)tr.toState >= rule.numStates();
+            o << "    " << (j + 1 < rule.numSymbols() ? "case " + std::to_string(j) : std::string("default"))
+              << ": d[p] = " << (int)tr.symbol << "; ++steps; s = " << (int)tr.toState << "; ";
+            if (tr.direction == direction::left)
+                o << "if (--p < lo) { if (p < 0) goto done; lo = p; } ";
+            else
+                o << "if (++p > hi) { if (p == size) goto done; hi = p; } ";
+            if (halts)
+                o << "goto done;\n";
+            else
+                o << "goto " << label(tr.toState) << ";\n";
+        }
+        o << "    }\n";
+    }
+    o << R"(done:
+    t->pos = p;
+    t->lo = lo;
+    t->hi = hi;
+    t->steps = steps;
+    t->state = s;
+}
+)";
+    return o.str();
+}
+
+/// A Turing machine compiled to native code at runtime and loaded as a shared object. Compiled machines are cached
+/// on disk and in memory by rule string, so each rule is only compiled once. Has the same interface as
+/// `TuringMachine`, except that `tape()` returns a copy.
+class CompiledTuringMachine
+{
+  public:
+    using run_function = void (*)(compiled_tape *, uint64_t);
+
+    /// Compiles (or loads from the cache) the given rule. Throws `std::runtime_error` if compilation fails.
+    explicit CompiledTuringMachine(turing_rule rule, const compile_options &options = {})
+        : _rule(rule), _library(load(rule, options))
+    {
+        _data.resize(initialSize);
+        _t = {.data = _data.data(),
+              .size = (int64_t)initialSize,
+              .pos = initialSize / 2,
+              .lo = initialSize / 2,
+              .hi = initialSize / 2,
+              .steps = 0,
+              .state = 0};
+    }
+
+    explicit CompiledTuringMachine(const std::string &code, const compile_options &options = {})
+        : CompiledTuringMachine(turing_rule(code), options)
+    {
+    }
+
+    [[nodiscard]] constexpr const turing_rule &rule() const { return _rule; }
+    [[nodiscard]] constexpr size_t numStates() const { return _rule.numStates(); }
+    [[nodiscard]] constexpr size_t numSymbols() const { return _rule.numSymbols(); }
+    [[nodiscard]] constexpr size_t steps() const { return _t.steps; }
+    [[nodiscard]] constexpr state_type state() const { return (state_type)_t.state; }
+    /// Returns whether the Turing machine is halted, i.e. in the Z state.
+    [[nodiscard]] constexpr bool halted() const { return state() < 0 || (size_t)state() >= numStates(); }
+    [[nodiscard]] constexpr int64_t head() const { return _t.pos - _offset; }
+    [[nodiscard]] constexpr int64_t leftEdge() const { return _t.lo - _offset; }
+    [[nodiscard]] constexpr int64_t rightEdge() const { return _t.hi - _offset; }
+    [[nodiscard]] symbol_type operator*() const { return _data[_t.pos]; }
+
+    /// Returns a copy of the visited part of the tape.
+    [[nodiscard]] Tape tape() const
+    {
+        return {{_data.begin() + _t.lo, _data.begin() + _t.hi + 1}, leftEdge(), head(), state()};
+    }
+
+    [[nodiscard]] size_t sigma() const
+    {
+        return std::count_if(_data.begin() + _t.lo, _data.begin() + _t.hi + 1, [](symbol_type x) { return x != 0; });
+    }
+
+    [[nodiscard]] bool blank() const { return sigma() == 0; }
+
+    /// Steps, and returns true if the machine advanced, false otherwise (for example, it was already halted).
+    TuringMachine::step_result step()
+    {
+        if (halted())
+            return {.success = false, .tapeExpanded = false};
+        const auto lo = _t.lo;
+        const auto hi = _t.hi;
+        seek(steps() + 1);
+        return {.success = true, .tapeExpanded = _t.lo != lo || _t.hi != hi};
+    }
+
+    /// Seeks forward to step number n, or until the machine halts.
+    void seek(size_t n)
+    {
+        _t.data = _data.data();
+        while (!halted() && _t.steps < n)
+        {
+            _run(&_t, n);
+            if (_t.pos < 0 || _t.pos >= _t.size)
+                grow();
+        }
+    }
+
+    [[nodiscard]] std::string str() const { return tape().str(); }
+    [[nodiscard]] std::string prettyStr(size_t width = Tape::defaultPrintWidth) const
+    {
+        return tape().prettyStr(width);
+    }
+
+    /// Returns the path of the shared object for the given rule, compiling it first if it is not in the cache. Its
+    /// source is next to it, with the extension .cpp. Throws `std::runtime_error` if compilation fails.
+    static std::filesystem::path compile(const turing_rule &rule, const compile_options &options = {})
+    {
+        namespace fs = std::filesystem;
+        const auto code = rule.str();
+        const auto name = code + "-" + options.cacheKey();
+        const auto lib = options.cacheDir / (name + ".so");
+        if (fs::exists(lib))
+            return lib;
+        fs::create_directories(options.cacheDir);
+        // Write and compile to unique names and then rename, so that concurrent processes never truncate a source that
+        // another one is compiling, or load a partial file.
+        const auto pid = std::to_string(getpid());
+        const auto src = options.cacheDir / (name + ".cpp");
+        const auto tmpSrc = options.cacheDir / (name + "." + pid + ".cpp");
+        const auto tmp = options.cacheDir / (name + ".so." + pid);
+        std::ofstream(tmpSrc) << generateSource(rule);
+        const auto command = options.compiler + " " + options.flags + " -shared -fPIC -o \"" + tmp.string() + "\" \"" +
+                             tmpSrc.string() + "\"";
+        if (options.verbose)
+            std::cout << command << '\n';
+        if (std::system(command.c_str()) != 0)
+        {
+            fs::remove(tmp);
+            fs::remove(tmpSrc);
+            throw std::runtime_error("Failed to compile " + code + " with command: " + command);
+        }
+        fs::rename(tmpSrc, src);
+        fs::rename(tmp, lib);
+        return lib;
+    }
+
+  private:
+    static constexpr size_t initialSize = 1024;
+
+    struct library
+    {
+        void *handle = nullptr;
+        run_function run = nullptr;
+
+        library() = default;
+        library(const library &) = delete;
+        library &operator=(const library &) = delete;
+        ~library()
+        {
+            if (handle != nullptr)
+                dlclose(handle);
+        }
+    };
+
+    turing_rule _rule;
+    std::shared_ptr<library> _library;
+    run_function _run = _library->run;
+    std::vector<symbol_type> _data;
+    compiled_tape _t{};
+    /// Index into `_data` of absolute position 0.
+    int64_t _offset = initialSize / 2;
+
+    /// Doubles the buffer on the side that the head ran off.
+    void grow()
+    {
+        const auto n = _data.size();
+        if (_t.pos < 0)
+        {
+            _data.insert(_data.begin(), n, 0);
+            _offset += (int64_t)n;
+            _t.pos += (int64_t)n;
+            _t.lo = _t.pos;
+            _t.hi += (int64_t)n;
+        }
+        else
+        {
+            _data.resize(2 * n);
+            _t.hi = _t.pos;
+        }
+        _t.data = _data.data();
+        _t.size = (int64_t)_data.size();
+    }
+
+    static std::shared_ptr<library> load(const turing_rule &rule, const compile_options &options)
+    {
+        static std::mutex mutex;
+        static std::unordered_map<std::string, std::weak_ptr<library>> cache;
+        const std::lock_guard lock(mutex);
+        const auto key = rule.str() + "-" + options.cacheKey();
+        if (auto lib = cache[key].lock())
+            return lib;
+        const auto path = compile(rule, options);
+        auto lib = std::make_shared<library>();
+        lib->handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+        if (lib->handle == nullptr)
+            throw std::runtime_error("Failed to load " + path.string() + ": " + dlerror());
+        lib->run = (run_function)dlsym(lib->handle, "turing_run");
+        if (lib->run == nullptr)
+            throw std::runtime_error("Missing turing_run in " + path.string());
+        cache[key] = lib;
+        return lib;
+    }
+};
+} // namespace turing
+
+#endif
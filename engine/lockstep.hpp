@@ -0,0 +1,195 @@
+#pragma once
+
+#include <span>
+
+#include "../turing.hpp"
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace turing
+{
+/// Why a lane of a `LockstepBatch` stopped.
+enum class lane_status : uint8_t
+{
+    /// Still running when the step budget ran out.
+    running,
+    /// Returned to an earlier configuration, so it cycles forever.
+    cycler,
+    /// Reached a halting or undefined transition.
+    halted,
+    /// The head left the tape window.
+    overflow
+};
+
+/// Simulates a batch of up to 32 machines with the same number of symbols in lockstep from a blank tape, in SIMD
+/// lanes, and detects cyclers with Brent's algorithm. The layout is structure-of-arrays: each lane holds a row index
+/// into a shared transition table, a head and a tape window packed into one 64-bit word (64, 32 or 16 cells depending
+/// on the number of symbols), and the transition is fetched with a gather. Lanes that halt, hit an undefined
+/// transition or run off the window are retired, to be handled by the scalar deciders.
+///
+/// Since a lane's whole tape is in its window, two equal (state, head, window) configurations prove that the machine
+/// is a cycler, and the reported period is exact.
+class LockstepBatch
+{
+  public:
+    /// Lanes per vector: 8 with AVX-512, otherwise 4.
+#ifdef __AVX512F__
+    static constexpr size_t vectorWidth = 8;
+#else
+    static constexpr size_t vectorWidth = 4;
+#endif
+    static constexpr size_t maxLanes = 32;
+
+    /// Precondition: `rules.size() <= maxLanes`, and all rules have the same number of symbols.
+    explicit LockstepBatch(std::span<const turing_rule> rules)
+        : _lanes(rules.size()), _bits(packedBitsPerCell(rules.empty() ? 2 : rules[0].numSymbols())),
+          _windowSize(64 / _bits), _table(maxLanes * rowStride, haltBit)
+    {
+        assert(rules.size() <= maxLanes);
+        for (size_t l = 0; l < _lanes; ++l)
+        {
+            const auto &rule = rules[l];
+            assert(packedBitsPerCell(rule.numSymbols()) == _bits);
+            for (size_t i = 0; i < rule.numStates(); ++i)
+                for (size_t j = 0; j < rule.numSymbols(); ++j)
+                {
+                    const auto &tr = rule[i, j];
+                    if (tr.toState >= 0 && (size_t)tr.toState < rule.numStates())
+                        _table[row(l, i) + j] = tr.symbol | (uint64_t)(tr.direction == direction::right) << 8 |
+                                                row(l, tr.toState) << 16;
+                }
+        }
+        for (size_t v = 0; v < numVectors; ++v)
+            for (size_t k = 0; k < vectorWidth; ++k)
+            {
+                const size_t l = v * vectorWidth + k;
+                _row[v][k] = row(l, 0);
+                _head[v][k] = _windowSize / 2;
+                _tape[v][k] = 0;
+                _active[v][k] = l < _lanes ? ~0UZ : 0;
+                _status[v][k] = 0;
+                _period[v][k] = 0;
+            }
+    }
+
+    [[nodiscard]] constexpr size_t size() const { return _lanes; }
+    /// Number of cells in each lane's tape window.
+    [[nodiscard]] constexpr size_t windowSize() const { return _windowSize; }
+    /// Number of lockstep steps run so far.
+    [[nodiscard]] constexpr size_t steps() const { return _steps; }
+    [[nodiscard]] lane_status status(size_t lane) const
+    {
+        return (lane_status)_status[lane / vectorWidth][lane % vectorWidth];
+    }
+    /// The period of a cycler lane.
+    [[nodiscard]] size_t period(size_t lane) const { return _period[lane / vectorWidth][lane % vectorWidth]; }
+
+    /// Runs all lanes for up to `maxSteps` steps, or until every lane is retired.
+    void run(size_t maxSteps)
+    {
+        size_t nextSave = _steps == 0 ? 1 : std::bit_ceil(_steps);
+        std::array<vector_type, numVectors> savedRow = _row;
+        std::array<vector_type, numVectors> savedHead = _head;
+        std::array<vector_type, numVectors> savedTape = _tape;
+        size_t savedStep = _steps;
+        const vector_type cellMask = splat((1UZ << _bits) - 1);
+        const vector_type bits = splat(_bits);
+        const vector_type windowSize = splat(_windowSize);
+        while (_steps < maxSteps)
+        {
+            ++_steps;
+            for (size_t v = 0; v < numVectors; ++v)
+            {
+                const vector_type active = _active[v];
+                const vector_type shift = (_head[v] * bits) & 63;
+                const vector_type cell = (_tape[v] >> shift) & cellMask;
+                const vector_type tr = gather(_row[v] + cell);
+                const vector_type halts = (vector_type)((tr & haltBit) != 0) & active;
+                const vector_type stepping = active & ~halts;
+                const vector_type tape = (_tape[v] & ~(cellMask << shift)) | (tr & 0xFF) << shift;
+                const vector_type head = _head[v] + ((tr >> 7) & 2) - 1;
+                _tape[v] = select(stepping, tape, _tape[v]);
+                _head[v] = select(stepping, head, _head[v]);
+                _row[v] = select(stepping, (tr >> 16) & 0xFFFF, _row[v]);
+                const vector_type overflows = (vector_type)(_head[v] >= windowSize) & stepping;
+                const vector_type cycles = (vector_type)(_row[v] == savedRow[v]) &
+                                           (vector_type)(_head[v] == savedHead[v]) &
+                                           (vector_type)(_tape[v] == savedTape[v]) & stepping & ~overflows;
+                _status[v] = select(halts, splat((size_t)lane_status::halted), _status[v]);
+                _status[v] = select(overflows, splat((size_t)lane_status::overflow), _status[v]);
+                _status[v] = select(cycles, splat((size_t)lane_status::cycler), _status[v]);
+                _period[v] = select(cycles, splat(_steps - savedStep), _period[v]);
+                _active[v] = active & ~halts & ~overflows & ~cycles;
+            }
+            if (_steps == nextSave)
+            {
+                savedRow = _row;
+                savedHead = _head;
+                savedTape = _tape;
+                savedStep = _steps;
+                nextSave *= 2;
+                if (!anyActive())
+                    break;
+            }
+        }
+    }
+
+  private:
+    using vector_type = size_t __attribute__((vector_size(vectorWidth * sizeof(size_t))));
+    static constexpr size_t numVectors = maxLanes / vectorWidth;
+    /// Table entries of halting and undefined transitions have this bit set.
+    static constexpr size_t haltBit = 1UZ << 63;
+    static constexpr size_t rowStride = maxStates * maxSymbols;
+
+    size_t _lanes;
+    size_t _bits;
+    size_t _windowSize;
+    /// Transitions of all lanes. Bits 0-7 are the symbol to write, bit 8 is set for a right move, and bits 16-31 are
+    /// the row of the next state.
+    std::vector<size_t> _table;
+    std::array<vector_type, numVectors> _row{};
+    std::array<vector_type, numVectors> _head{};
+    std::array<vector_type, numVectors> _tape{};
+    /// All ones in lanes that are still running.
+    std::array<vector_type, numVectors> _active{};
+    std::array<vector_type, numVectors> _status{};
+    std::array<vector_type, numVectors> _period{};
+    size_t _steps = 0;
+
+    static constexpr size_t row(size_t lane, size_t state) { return lane * rowStride + state * maxSymbols; }
+
+    static constexpr vector_type splat(size_t x) { return vector_type{} + x; }
+
+    static constexpr vector_type select(vector_type mask, vector_type a, vector_type b)
+    {
+        return (a & mask) | (b & ~mask);
+    }
+
+    [[nodiscard]] vector_type gather(vector_type index) const
+    {
+#if defined(__AVX512F__)
+        return (vector_type)_mm512_i64gather_epi64((__m512i)index, (const long long *)_table.data(), 8);
+#elif defined(__AVX2__)
+        return (vector_type)_mm256_i64gather_epi64((const long long *)_table.data(), (__m256i)index, 8);
+#else
+        vector_type res;
+        for (size_t k = 0; k < vectorWidth; ++k)
+            res[k] = _table[index[k]];
+        return res;
+#endif
+    }
+
+    [[nodiscard]] bool anyActive() const
+    {
+        vector_type any{};
+        for (auto &&a : _active)
+            any |= a;
+        for (size_t k = 0; k < vectorWidth; ++k)
+            if (any[k] != 0)
+                return true;
+        return false;
+    }
+};
+} // namespace turing
@@ -0,0 +1,278 @@
+#pragma once
+
+#include <boost/unordered/unordered_flat_map.hpp>
+
+#include "../turing.hpp"
+
+namespace turing
+{
+/// A cached transition of a block macro machine: the result of running the base machine inside one block until its
+/// head leaves the block or the machine halts. If it does neither within `MacroTuringMachine::maxBlockSteps` steps, the
+/// transition is unknown, and `pos` is inside the block.
+struct block_transition
+{
+    /// The block after the transition.
+    uint64_t block = 0;
+    /// Number of base steps taken.
+    size_t steps = 0;
+    state_type state = 0;
+    /// Head position relative to the block after the transition: -1 or the block size if it left the block.
+    int8_t pos = 0;
+};
+
+/// Key of a block transition. `pos` is the entry side (0 or the block size minus 1), or any cell in the block after a
+/// partial step.
+struct block_key
+{
+    uint64_t block = 0;
+    state_type state = 0;
+    int8_t pos = 0;
+
+    constexpr friend bool operator==(const block_key &a, const block_key &b) = default;
+};
+
+/// Hash
+constexpr size_t hash_value(const block_key &k)
+{
+    size_t seed = 0;
+    boost::hash_combine(seed, k.block);
+    boost::hash_combine(seed, k.state);
+    boost::hash_combine(seed, k.pos);
+    return seed;
+}
+
+/// Statistics of a block macro machine run.
+struct macro_stats
+{
+    size_t macroSteps = 0;
+    size_t cacheHits = 0;
+    size_t cacheMisses = 0;
+    /// Base steps simulated to fill the cache, including uncached partial steps.
+    size_t missSteps = 0;
+
+    [[nodiscard]] constexpr double hitRate() const
+    {
+        return cacheHits + cacheMisses == 0 ? 0 : (double)cacheHits / (cacheHits + cacheMisses);
+    }
+};
+
+/// A Turing machine that treats `k` consecutive cells as one macro symbol. Transitions of the form (state, block,
+/// entry side) are simulated cell by cell the first time they are seen and memoized in a hash table.
+class MacroTuringMachine
+{
+  public:
+    /// Upper bound on base steps simulated inside a block before giving up on caching the transition.
+    static constexpr size_t maxBlockSteps = 1 << 20;
+
+    /// Precondition: `blockSize * packedBitsPerCell(rule.numSymbols()) <= 64`.
+    MacroTuringMachine(turing_rule rule, size_t blockSize)
+        : _rule(rule), _k(blockSize), _bits(packedBitsPerCell(rule.numSymbols())), _mask((1U << _bits) - 1)
+    {
+        assert(_k >= 1 && _k * _bits <= 64);
+    }
+
+    /// Initializes a macro machine from a code in TNF format.
+    MacroTuringMachine(std::string code, size_t blockSize) : MacroTuringMachine(turing_rule(std::move(code)), blockSize)
+    {
+    }
+
+    [[nodiscard]] constexpr const turing_rule &rule() const { return _rule; }
+    [[nodiscard]] constexpr size_t blockSize() const { return _k; }
+    [[nodiscard]] constexpr size_t steps() const { return _steps; }
+    [[nodiscard]] constexpr size_t macroSteps() const { return _stats.macroSteps; }
+    [[nodiscard]] constexpr const macro_stats &stats() const { return _stats; }
+    /// The number of distinct cached transitions.
+    [[nodiscard]] size_t cacheSize() const { return _cache.size(); }
+    [[nodiscard]] constexpr state_type state() const { return _state; }
+
+    /// Returns whether the Turing machine is halted, i.e. in the Z state.
+    [[nodiscard]] constexpr bool halted() const { return _state < 0 || (size_t)_state >= _rule.numStates(); }
+
+    /// Returns the absolute position of the head.
+    [[nodiscard]] constexpr int64_t head() const { return _block * (int64_t)_k + _pos; }
+
+    /// Gets the symbol at the given absolute position (zero being the initial position).
+    [[nodiscard]] symbol_type operator[](int64_t i) const
+    {
+        const auto b = floorDiv(i, (int64_t)_k);
+        const auto j = b + _offset;
+        if (j < 0 || (size_t)j >= _data.size())
+            return 0;
+        return (_data[j] >> ((i - b * (int64_t)_k) * _bits)) & _mask;
+    }
+
+    /// The number of nonzero symbols on the tape.
+    [[nodiscard]] size_t sigma() const
+    {
+        size_t res = 0;
+        for (auto block : _data)
+            for (size_t i = 0; i < _k; ++i)
+                res += ((block >> (i * _bits)) & _mask) != 0;
+        return res;
+    }
+
+    /// Takes one macro step of at most `maxSteps` base steps. Returns false, without stepping, if the machine was
+    /// already halted, or if the head stays inside the block for `maxBlockSteps` steps and `maxSteps` is at least that.
+    bool step(size_t maxSteps)
+    {
+        if (halted() || maxSteps == 0)
+            return false;
+        auto &block = _data[_block + _offset];
+        const block_key key{.block = block, .state = _state, .pos = (int8_t)_pos};
+        const block_transition *tr = nullptr;
+        if (auto it = _cache.find(key); it != _cache.end())
+        {
+            ++_stats.cacheHits;
+            tr = &it->second;
+        }
+        else
+        {
+            ++_stats.cacheMisses;
+            tr = &(_cache[key] = simulateBlock(key, maxBlockSteps));
+            _stats.missSteps += tr->steps;
+        }
+        block_transition partial;
+        if (tr->steps <= maxSteps && tr->pos >= 0 && tr->pos < (int)_k && !halted(tr->state))
+            return false;
+        if (tr->steps > maxSteps)
+        {
+            partial = simulateBlock(key, maxSteps);
+            _stats.missSteps += partial.steps;
+            tr = &partial;
+        }
+        ++_stats.macroSteps;
+        _steps += tr->steps;
+        block = tr->block;
+        _state = tr->state;
+        if (tr->pos < 0)
+        {
+            moveLeft();
+            _pos = _k - 1;
+        }
+        else if (tr->pos >= (int)_k)
+        {
+            moveRight();
+            _pos = 0;
+        }
+        else
+            _pos = tr->pos;
+        return true;
+    }
+
+    /// Seeks forward to step number n, or until the machine halts or a step fails (see `step`).
+    void seek(size_t n)
+    {
+        while (_steps < n)
+            if (!step(n - _steps))
+                break;
+    }
+
+    /// Returns a string representation of the visited blocks.
+    [[nodiscard]] std::string str() const
+    {
+        std::string s{(char)(_state + 'A'), ' '};
+        for (int64_t i = _leftBlock * (int64_t)_k; i < (_rightBlock + 1) * (int64_t)_k; ++i)
+        {
+            if (i == head())
+                s += ">";
+            s += (char)('0' + (*this)[i]);
+        }
+        return s;
+    }
+
+  private:
+    turing_rule _rule;
+    size_t _k;
+    size_t _bits;
+    uint64_t _mask;
+    std::vector<uint64_t> _data{0};
+    int64_t _offset = 0;
+    /// Absolute index of the block under the head.
+    int64_t _block = 0;
+    int64_t _leftBlock = 0;
+    int64_t _rightBlock = 0;
+    /// Head position within the block.
+    size_t _pos = 0;
+    state_type _state = 0;
+    size_t _steps = 0;
+    macro_stats _stats;
+    boost::unordered_flat_map<block_key, block_transition> _cache;
+
+    [[nodiscard]] constexpr bool halted(state_type state) const
+    {
+        return state < 0 || (size_t)state >= _rule.numStates();
+    }
+
+    /// Runs the base machine inside one block for at most `maxSteps` steps.
+    [[nodiscard]] block_transition simulateBlock(const block_key &key, size_t maxSteps) const
+    {
+        block_transition res{.block = key.block, .steps = 0, .state = key.state, .pos = key.pos};
+        while (res.steps < maxSteps && !halted(res.state))
+        {
+            const auto shift = res.pos * _bits;
+            const auto &tr = _rule[res.state, (res.block >> shift) & _mask];
+            res.block = (res.block & ~(_mask << shift)) | (uint64_t)tr.symbol << shift;
+            res.state = tr.toState;
+            res.pos += tr.direction == direction::left ? -1 : 1;
+            ++res.steps;
+            if (res.pos < 0 || res.pos >= (int)_k)
+                break;
+        }
+        return res;
+    }
+
+    void moveLeft()
+    {
+        --_block;
+        if (_block < _leftBlock)
+        {
+            --_leftBlock;
+            if (_block + _offset < 0)
+            {
+                const size_t n = _data.size();
+                _data.insert(_data.begin(), n, 0);
+                _offset += n;
+            }
+        }
+    }
+
+    void moveRight()
+    {
+        ++_block;
+        if (_block > _rightBlock)
+        {
+            ++_rightBlock;
+            if (_block + _offset >= (int64_t)_data.size())
+                _data.resize(2 * _data.size());
+        }
+    }
+};
+
+/// Picks a block size for `MacroTuringMachine` by running each candidate for `probeSteps` base steps and choosing the
+/// one that minimizes macro steps plus base steps spent filling the cache.
+/// @param verbose Whether to print the statistics of each candidate.
+inline size_t findBlockSize(const turing_rule &rule, size_t probeSteps = 100000, size_t maxBlockSize = 24,
+                            bool verbose = false)
+{
+    maxBlockSize = std::min(maxBlockSize, 64 / packedBitsPerCell(rule.numSymbols()));
+    size_t best = 1;
+    size_t bestCost = std::numeric_limits<size_t>::max();
+    for (size_t k = 1; k <= maxBlockSize; ++k)
+    {
+        MacroTuringMachine m{rule, k};
+        m.seek(probeSteps);
+        const auto &stats = m.stats();
+        const size_t cost = stats.macroSteps + stats.missSteps;
+        if (verbose)
+            std::cout << "  k = " << std::setw(2) << k << " | macro steps = " << std::setw(8) << stats.macroSteps
+                      << " | cache size = " << std::setw(6) << m.cacheSize()
+                      << " | hit rate = " << 100 * stats.hitRate() << "%\n";
+        if (cost < bestCost)
+        {
+            best = k;
+            bestCost = cost;
+        }
+    }
+    return best;
+}
+} // namespace turing
@@ -0,0 +1,247 @@
+#pragma once
+
+#include "../turing.hpp"
+
+#if __has_include(<sys/mman.h>)
+#define TURING_MAPPED_TAPE
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace turing
+{
+/// A Turing tape backed by a large range of virtual memory reserved with `mmap`, centered on the origin, along with a
+/// head and a state. The OS supplies zero pages lazily as the head reaches them, so stepping never reallocates or
+/// moves data, and the head is a plain pointer. Each end of the range has a `PROT_NONE` guard page, so a machine that
+/// runs off the reservation crashes instead of corrupting memory. Has the same interface as `Tape`.
+class MappedTape
+{
+  public:
+    static constexpr size_t defaultPrintWidth = Tape::defaultPrintWidth;
+    /// 4 GiB of cells on each side of the origin. Only the pages the head visits use memory.
+    static constexpr size_t defaultCellsPerSide = 1UZ << 32;
+
+    MappedTape() : MappedTape(defaultCellsPerSide) {}
+
+    /// Reserves `cellsPerSide` cells on each side of the origin. If `hugePages` is true, asks the kernel to back the
+    /// tape with transparent huge pages. Throws `std::bad_alloc` if the reservation fails.
+    explicit MappedTape(size_t cellsPerSide, bool hugePages = false)
+        : _cellsPerSide(roundToPage(cellsPerSide)), _hugePages(hugePages)
+    {
+        map();
+    }
+
+    MappedTape(const MappedTape &other)
+        : _cellsPerSide(other._cellsPerSide), _hugePages(other._hugePages), _state(other._state)
+    {
+        map();
+        _head = _origin + other.head();
+        _left = _origin + other.leftEdge();
+        _right = _origin + other.rightEdge();
+        std::copy(other._left, other._right + 1, _left);
+    }
+
+    MappedTape(MappedTape &&other) noexcept
+        : _base(std::exchange(other._base, nullptr)), _mapSize(other._mapSize), _cellsPerSide(other._cellsPerSide),
+          _hugePages(other._hugePages), _origin(other._origin), _head(other._head), _left(other._left),
+          _right(other._right), _state(other._state)
+    {
+    }
+
+    MappedTape &operator=(MappedTape other) noexcept
+    {
+        swap(*this, other);
+        return *this;
+    }
+
+    ~MappedTape()
+    {
+        if (_base != nullptr)
+            munmap(_base, _mapSize);
+    }
+
+    friend void swap(MappedTape &a, MappedTape &b) noexcept
+    {
+        std::swap(a._base, b._base);
+        std::swap(a._mapSize, b._mapSize);
+        std::swap(a._cellsPerSide, b._cellsPerSide);
+        std::swap(a._hugePages, b._hugePages);
+        std::swap(a._origin, b._origin);
+        std::swap(a._head, b._head);
+        std::swap(a._left, b._left);
+        std::swap(a._right, b._right);
+        std::swap(a._state, b._state);
+    }
+
+    symbol_type &operator*() { return *_head; }
+    constexpr symbol_type operator*() const { return *_head; }
+
+    /// Gets the symbol at the given absolute position (zero being the initial position).
+    constexpr symbol_type operator[](ptrdiff_t i) const
+    {
+        return i >= -(int64_t)_cellsPerSide && i < (int64_t)_cellsPerSide ? _origin[i] : 0;
+    }
+
+    /// Returns a pointer to the cell at absolute position 0.
+    [[nodiscard]] constexpr const symbol_type *data() const { return _origin; }
+    /// Returns the absolute position of the head.
+    [[nodiscard]] constexpr int64_t head() const { return _head - _origin; }
+    [[nodiscard]] constexpr int64_t offset() const { return (int64_t)_cellsPerSide; }
+
+    /// The left edge of the tape.
+    [[nodiscard]] constexpr int64_t leftEdge() const { return _left - _origin; }
+    // The right edge of the tape.
+    [[nodiscard]] constexpr int64_t rightEdge() const { return _right - _origin; }
+    /// The size of the tape.
+    [[nodiscard]] constexpr size_t size() const { return rightEdge() - leftEdge() + 1; }
+    [[nodiscard]] constexpr size_t state() const { return _state; }
+
+    /// Returns whether the tape consists of all zeros.
+    [[nodiscard]] constexpr bool blank() const
+    {
+        return std::all_of(_left, _right + 1, [](symbol_type x) { return x == 0; });
+    }
+
+    /// The number of nonzero symbols on the tape.
+    [[nodiscard]] constexpr size_t sigma() const
+    {
+        return std::count_if(_left, _right + 1, [](symbol_type x) { return x != 0; });
+    }
+
+    /// Steps, and returns whether the tape expanded as a result of the step.
+    constexpr bool step(const transition &tr)
+    {
+        *_head = tr.symbol;
+        _state = tr.toState;
+        if (tr.direction == direction::left)
+        {
+            if (--_head < _left)
+            {
+                _left = _head;
+                return true;
+            }
+        }
+        else if (++_head > _right)
+        {
+            _right = _head;
+            return true;
+        }
+        return false;
+    }
+
+    /// Returns a string representation of this tape.
+    [[nodiscard]] constexpr std::string str() const
+    {
+        std::string s{(char)(_state + 'A'), ' '};
+        for (const symbol_type *p = _left; p <= _right; ++p)
+        {
+            if (p == _head)
+                s += ">";
+            s += (char)('0' + *p);
+        }
+        return s;
+    }
+
+    /// Returns a string representation of this tape, colored for the terminal.
+    [[nodiscard]] constexpr std::string prettyStr(size_t width = defaultPrintWidth) const
+    {
+        std::string s;
+        const auto headPrefix = getBgStyle(_state);
+        const auto headSuffix = ansi::str(ansi::bgDefault);
+        const int64_t shift = width / 2;
+        const int64_t start = width * floorDiv((int64_t)(head() + shift), (int64_t)width) - shift;
+        for (int64_t i = start; i < (int64_t)(start + width); ++i)
+        {
+            if (i == head())
+                s += headPrefix;
+            s += (i >= leftEdge() && i <= rightEdge() ? (char)('0' + (*this)[i]) : ' ');
+            if (i == head())
+                s += headSuffix;
+        }
+        return s;
+    }
+
+    /// @brief Gets the tape segment between `start` and `stop`, inclusive.
+    /// @param start The start position (inclusive).
+    /// @param stop The stop position (inclusive).
+    [[nodiscard]] tape_segment getSegment(int64_t start, int64_t stop) const
+    {
+        std::vector<symbol_type> v(size_t(stop - start + 1));
+        for (int64_t i = start; i <= stop; ++i)
+            v[i - start] = (*this)[i];
+        return {.state = _state, .data = v, .head = head() - start};
+    }
+
+    template <typename CharT, typename Traits>
+    friend std::basic_ostream<CharT, Traits> &operator<<(std::basic_ostream<CharT, Traits> &o, const MappedTape &t)
+    {
+        return o << t.str();
+    }
+
+  private:
+    /// The mapping, including the guard pages.
+    void *_base = nullptr;
+    size_t _mapSize = 0;
+    size_t _cellsPerSide = 0;
+    bool _hugePages = false;
+    symbol_type *_origin = nullptr;
+    symbol_type *_head = nullptr;
+    symbol_type *_left = nullptr;
+    symbol_type *_right = nullptr;
+    state_type _state = 0;
+
+    static size_t pageSize()
+    {
+        static const auto size = (size_t)sysconf(_SC_PAGESIZE);
+        return size;
+    }
+
+    static size_t roundToPage(size_t n) { return (std::max(n, 1UZ) + pageSize() - 1) / pageSize() * pageSize(); }
+
+    /// Maps a zeroed range of `2 * _cellsPerSide` cells between two guard pages, and puts the head at its center.
+    void map()
+    {
+        const auto page = pageSize();
+        _mapSize = 2 * _cellsPerSide + 2 * page;
+        _base = mmap(nullptr, _mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (_base == MAP_FAILED)
+        {
+            _base = nullptr;
+            throw std::bad_alloc();
+        }
+        auto *cells = (symbol_type *)_base + page;
+        if (mprotect(_base, page, PROT_NONE) != 0 || mprotect(cells + 2 * _cellsPerSide, page, PROT_NONE) != 0)
+        {
+            munmap(std::exchange(_base, nullptr), _mapSize);
+            throw std::bad_alloc();
+        }
+#ifdef MADV_HUGEPAGE
+        if (_hugePages)
+            madvise(cells, 2 * _cellsPerSide, MADV_HUGEPAGE);
+#endif
+        _origin = cells + _cellsPerSide;
+        _head = _left = _right = _origin;
+    }
+};
+
+/// Returns whether the given spans of t1 and t2, relative to their head positions, are identical. Compares the spans
+/// directly in memory when both lie inside the reservations.
+inline bool spansEqual(const MappedTape &t1, const MappedTape &t2, int64_t start, int64_t end)
+{
+    const auto inside = [&](const MappedTape &t) {
+        return t.head() + start >= -t.offset() && t.head() + end < t.offset();
+    };
+    if (start > end)
+        return true;
+    if (inside(t1) && inside(t2))
+        return std::memcmp(t1.data() + t1.head() + start, t2.data() + t2.head() + start, end - start + 1) == 0;
+    for (int64_t i = start; i <= end; ++i)
+        if (t1[t1.head() + i] != t2[t2.head() + i])
+            return false;
+    return true;
+}
+
+using MappedTuringMachine = BasicTuringMachine<MappedTape>;
+} // namespace turing
+
+#endif
@@ -0,0 +1,535 @@
+#pragma once
+
+#include <boost/multiprecision/cpp_int.hpp>
+#include <boost/unordered/unordered_flat_map.hpp>
+
+#include "macro.hpp"
+
+namespace turing
+{
+/// Arbitrary-precision integer for the step counts and exponents of `ProofTuringMachine`.
+using big_int = boost::multiprecision::cpp_int;
+
+/// An affine expression `constant + Σ a_i x_i` in the exponents `x_i` of a general configuration.
+struct affine_expr
+{
+    big_int constant = 0;
+    /// Coefficients `(i, a_i)` of the variables that occur, sorted by `i`.
+    std::vector<std::pair<size_t, big_int>> coeffs;
+
+    affine_expr(big_int c = 0) : constant(std::move(c)) {}
+
+    static affine_expr variable(size_t i)
+    {
+        affine_expr e;
+        e.coeffs.emplace_back(i, 1);
+        return e;
+    }
+
+    [[nodiscard]] bool isConstant() const { return coeffs.empty(); }
+
+    /// Returns whether this is `x_i + c` for some `c`.
+    [[nodiscard]] bool isShiftOf(size_t i) const
+    {
+        return coeffs.size() == 1 && coeffs[0].first == i && coeffs[0].second == 1;
+    }
+
+    affine_expr &operator+=(const affine_expr &other)
+    {
+        constant += other.constant;
+        std::vector<std::pair<size_t, big_int>> res;
+        size_t a = 0;
+        size_t b = 0;
+        while (a < coeffs.size() || b < other.coeffs.size())
+            if (b == other.coeffs.size() || (a < coeffs.size() && coeffs[a].first < other.coeffs[b].first))
+                res.push_back(std::move(coeffs[a++]));
+            else if (a == coeffs.size() || other.coeffs[b].first < coeffs[a].first)
+                res.push_back(other.coeffs[b++]);
+            else
+            {
+                big_int c = coeffs[a].second + other.coeffs[b].second;
+                if (c != 0)
+                    res.emplace_back(coeffs[a].first, std::move(c));
+                ++a;
+                ++b;
+            }
+        coeffs = std::move(res);
+        return *this;
+    }
+
+    friend affine_expr operator*(affine_expr e, const big_int &x)
+    {
+        if (x == 0)
+            return {};
+        e.constant *= x;
+        for (auto &&[i, a] : e.coeffs)
+            a *= x;
+        return e;
+    }
+
+    template <typename CharT, typename Traits>
+    friend std::basic_ostream<CharT, Traits> &operator<<(std::basic_ostream<CharT, Traits> &o, const affine_expr &e)
+    {
+        for (auto &&[i, a] : e.coeffs)
+            o << (a == 1 ? "" : a.str()) << 'x' << i << " + ";
+        return o << e.constant;
+    }
+};
+
+/// `count` consecutive copies of a block of cells.
+template <typename Count> struct block_run
+{
+    uint64_t block = 0;
+    Count count{};
+};
+
+/// A configuration of `ProofTuringMachine`. The head sits between two blocks and faces one of them.
+template <typename Count> struct proof_config
+{
+    state_type state = 0;
+    /// The side the head faces. It reads the nearest block on that side next.
+    direction dir = direction::right;
+    /// Runs to the left and to the right of the head, nearest last. Blanks beyond the last run are implicit.
+    std::vector<block_run<Count>> left;
+    std::vector<block_run<Count>> right;
+    Count steps{};
+};
+
+/// A rule proven by `ProofTuringMachine`: from any configuration with a given shape whose variable exponents satisfy
+/// `x_i ≥ mins[i]`, the machine reaches the configuration of the same shape with exponents `x_i + deltas[i]` after
+/// `steps(x)` steps.
+struct proof_rule
+{
+    std::vector<big_int> deltas;
+    std::vector<big_int> mins;
+    affine_expr steps;
+};
+
+enum class proof_status : uint8_t
+{
+    running,
+    halted,
+    /// Proven to run forever.
+    infinite,
+    /// A block transition ran too long to tell whether it ever leaves the block.
+    unknown
+};
+
+/// Statistics of a proof engine run.
+struct proof_stats
+{
+    /// Macro steps taken outside of proofs.
+    size_t macroSteps = 0;
+    size_t rulesProven = 0;
+    size_t ruleApplications = 0;
+};
+
+/// A Turing machine simulator for machines that run far too long to simulate step by step. The tape is a sequence of
+/// runs `b^n` of blocks of `k` cells with arbitrary-precision exponents, and transitions are block transitions as in
+/// `MacroTuringMachine`. On top of chain steps, which cross a whole run at once, it proves rules by induction:
+///
+/// 1. When two configurations with the same shape (state, direction, and the block of each run, and which exponents
+///    are 1) come up with only plain macro steps between them, it replays those steps on the earlier configuration
+///    with every exponent other than 1 replaced by a variable `x_i`, keeping exponents as affine expressions. A
+///    decrement of `x_i + c` is allowed by requiring `x_i ≥ 2 - c`; anything else that depends on the variables fails
+///    the proof.
+/// 2. If the replay ends in the same shape with exponents `x_i + d_i`, then for all `x_i` above the required minimums
+///    the machine goes from the shape with exponents `x` to `x + d` in a number of steps affine in `x`.
+/// 3. Whenever a proven shape comes up again, the rule is applied as many times as the minimums allow at once, with
+///    the step count summed in closed form. If no exponent decreases, the machine never halts.
+///
+/// This is the approach of Shawn Ligocki's and Nick Drozd's simulators, without nested proofs.
+class ProofTuringMachine
+{
+  public:
+    /// Upper bound on base steps simulated inside one block before giving up.
+    static constexpr size_t maxBlockSteps = MacroTuringMachine::maxBlockSteps;
+    /// The history of past configurations is cleared when it reaches this size.
+    static constexpr size_t maxHistory = 1 << 16;
+    /// Configurations with more runs than this are stepped without looking for rules, since the shape of a tape that
+    /// doesn't compress well rarely repeats and comparing shapes would dominate the run time.
+    static constexpr size_t maxProofRuns = 64;
+    /// Upper bound on the macro steps replayed in a proof attempt.
+    static constexpr size_t maxProofSteps = 1000;
+
+    /// Precondition: `blockSize * packedBitsPerCell(rule.numSymbols()) <= 64`.
+    ProofTuringMachine(turing_rule rule, size_t blockSize)
+        : _rule(rule), _k(blockSize), _bits(packedBitsPerCell(rule.numSymbols())), _mask((1U << _bits) - 1)
+    {
+        assert(_k >= 1 && _k * _bits <= 64);
+    }
+
+    /// Initializes the machine from a code in TNF format.
+    ProofTuringMachine(std::string code, size_t blockSize) : ProofTuringMachine(turing_rule(std::move(code)), blockSize)
+    {
+    }
+
+    [[nodiscard]] constexpr const turing_rule &rule() const { return _rule; }
+    [[nodiscard]] constexpr size_t blockSize() const { return _k; }
+    [[nodiscard]] constexpr proof_status status() const { return _status; }
+    [[nodiscard]] constexpr const big_int &steps() const { return _config.steps; }
+    [[nodiscard]] constexpr state_type state() const { return _config.state; }
+    [[nodiscard]] constexpr const proof_config<big_int> &config() const { return _config; }
+    [[nodiscard]] constexpr const proof_stats &stats() const { return _stats; }
+
+    /// The number of nonzero symbols on the tape.
+    [[nodiscard]] big_int sigma() const
+    {
+        big_int res = 0;
+        for (auto &&runs : {&_config.left, &_config.right})
+            for (auto &&r : *runs)
+                res += r.count * nonzeroCells(r.block);
+        return res;
+    }
+
+    /// Runs for at most `maxIterations` iterations, each a macro step, a rule application or a proof. Returns the
+    /// status afterwards.
+    proof_status run(size_t maxIterations)
+    {
+        for (size_t i = 0; i < maxIterations && _status == proof_status::running; ++i)
+        {
+            if (_config.left.size() + _config.right.size() > maxProofRuns)
+            {
+                plainStep();
+                continue;
+            }
+            auto key = shape(_config);
+            if (auto it = _rules.find(key); it != _rules.end() && applyRule(it->second))
+                continue;
+            if (auto it = _history.find(key); it != _history.end())
+            {
+                const auto n = _plainSteps - it->second.second;
+                if (auto rule = n <= maxProofSteps ? prove(it->second.first, n) : std::nullopt)
+                {
+                    _rules[std::move(key)] = std::move(*rule);
+                    ++_stats.rulesProven;
+                    _history.clear();
+                    continue;
+                }
+                it->second = {_config, _plainSteps};
+            }
+            else
+            {
+                if (_history.size() >= maxHistory)
+                    _history.clear();
+                _history.emplace(std::move(key), std::pair{_config, _plainSteps});
+            }
+            plainStep();
+        }
+        return _status;
+    }
+
+    /// Returns a string representation of the tape, e.g. `A 1^3 10^12 > 1^4`.
+    [[nodiscard]] std::string str() const
+    {
+        std::ostringstream ss;
+        ss << (char)(_config.state + 'A');
+        for (auto &&r : _config.left)
+            ss << ' ' << blockStr(r.block) << '^' << r.count;
+        ss << (_config.dir == direction::right ? " >" : " <");
+        for (auto it = _config.right.rbegin(); it != _config.right.rend(); ++it)
+            ss << ' ' << blockStr(it->block) << '^' << it->count;
+        return std::move(ss).str();
+    }
+
+  private:
+    using shape_type = std::vector<uint64_t>;
+
+    /// The result of running the base machine inside one block from one of its sides.
+    struct block_result
+    {
+        uint64_t block = 0;
+        size_t steps = 0;
+        state_type state = 0;
+        /// The side the head left the block on.
+        direction dir = direction::right;
+        /// `running` if the head left the block.
+        proof_status status = proof_status::running;
+    };
+
+    turing_rule _rule;
+    size_t _k;
+    size_t _bits;
+    uint64_t _mask;
+    proof_config<big_int> _config;
+    proof_status _status = proof_status::running;
+    proof_stats _stats;
+    /// Number of plain macro steps so far, to count the steps between two configurations in the history.
+    size_t _plainSteps = 0;
+    boost::unordered_flat_map<block_key, block_result> _cache;
+    boost::unordered_flat_map<shape_type, std::pair<proof_config<big_int>, size_t>> _history;
+    boost::unordered_flat_map<shape_type, proof_rule> _rules;
+
+    [[nodiscard]] constexpr bool halted(state_type state) const
+    {
+        return state < 0 || (size_t)state >= _rule.numStates();
+    }
+
+    [[nodiscard]] size_t nonzeroCells(uint64_t block) const
+    {
+        size_t res = 0;
+        for (size_t i = 0; i < _k; ++i)
+            res += ((block >> (i * _bits)) & _mask) != 0;
+        return res;
+    }
+
+    [[nodiscard]] std::string blockStr(uint64_t block) const
+    {
+        std::string s;
+        for (size_t i = 0; i < _k; ++i)
+            s += (char)('0' + ((block >> (i * _bits)) & _mask));
+        return s;
+    }
+
+    /// The shape of a configuration: everything but the exponents, and which exponents are 1.
+    static shape_type shape(const proof_config<big_int> &config)
+    {
+        shape_type res{(uint64_t)config.state, (uint64_t)config.dir, config.left.size()};
+        for (auto &&runs : {&config.left, &config.right})
+            for (auto &&r : *runs)
+            {
+                res.push_back(r.block);
+                res.push_back(r.count == 1);
+            }
+        return res;
+    }
+
+    /// Runs the base machine inside one block, entering from the given side, until its head leaves the block, it
+    /// halts, or it provably loops inside the block.
+    [[nodiscard]] block_result simulateBlock(uint64_t block, state_type state, direction dir) const
+    {
+        block_result res{.block = block, .steps = 0, .state = state};
+        int pos = dir == direction::right ? 0 : (int)_k - 1;
+        // Brent's algorithm on the (block, state, position) of the base machine
+        auto saved = std::tuple{res.block, res.state, pos};
+        for (size_t nextSave = 1;; ++res.steps)
+        {
+            if (halted(res.state))
+            {
+                res.status = proof_status::halted;
+                return res;
+            }
+            if (pos < 0 || pos >= (int)_k)
+            {
+                res.dir = pos < 0 ? direction::left : direction::right;
+                return res;
+            }
+            if (res.steps > 0 && std::tuple{res.block, res.state, pos} == saved)
+            {
+                res.status = proof_status::infinite;
+                return res;
+            }
+            if (res.steps == nextSave)
+            {
+                saved = {res.block, res.state, pos};
+                nextSave *= 2;
+            }
+            if (res.steps >= maxBlockSteps)
+            {
+                res.status = proof_status::unknown;
+                return res;
+            }
+            const auto shift = pos * _bits;
+            const auto &tr = _rule[res.state, (res.block >> shift) & _mask];
+            res.block = (res.block & ~(_mask << shift)) | (uint64_t)tr.symbol << shift;
+            res.state = tr.toState;
+            pos += tr.direction == direction::left ? -1 : 1;
+        }
+    }
+
+    block_result transition(uint64_t block, state_type state, direction dir)
+    {
+        const block_key key{.block = block, .state = state, .pos = (int8_t)(dir == direction::right ? 0 : _k - 1)};
+        if (auto it = _cache.find(key); it != _cache.end())
+            return it->second;
+        return _cache[key] = simulateBlock(block, state, dir);
+    }
+
+    template <typename Count> static void push(std::vector<block_run<Count>> &runs, uint64_t block, Count count)
+    {
+        if (!runs.empty() && runs.back().block == block)
+            runs.back().count += count;
+        else if (block != 0 || !runs.empty())
+            runs.push_back({block, std::move(count)});
+    }
+
+    /// Takes one macro step. `takeOne(count)` decrements a run's exponent and returns whether the run is used up, or
+    /// nothing if that can't be decided. Returns `running` unless the machine halts or provably runs forever, or the
+    /// step can't be taken.
+    template <typename Count, typename TakeOne> proof_status step(proof_config<Count> &config, TakeOne &&takeOne)
+    {
+        auto &front = config.dir == direction::right ? config.right : config.left;
+        const auto tr = transition(front.empty() ? 0 : front.back().block, config.state, config.dir);
+        if (tr.status == proof_status::running && tr.state == config.state && tr.dir == config.dir)
+        {
+            // Chain step: the head crosses the whole run.
+            if (front.empty())
+                return proof_status::infinite;
+            auto run = std::move(front.back());
+            front.pop_back();
+            config.steps += run.count * big_int(tr.steps);
+            push(config.dir == direction::right ? config.left : config.right, tr.block, std::move(run.count));
+            return proof_status::running;
+        }
+        if (tr.status == proof_status::infinite || tr.status == proof_status::unknown)
+            return tr.status;
+        if (!front.empty())
+        {
+            const auto usedUp = takeOne(front.back().count);
+            if (!usedUp)
+                return proof_status::unknown;
+            if (*usedUp)
+                front.pop_back();
+        }
+        push(tr.dir == direction::right ? config.left : config.right, tr.block, Count{1});
+        config.steps += Count{tr.steps};
+        config.state = tr.state;
+        config.dir = tr.dir;
+        return tr.status;
+    }
+
+    void plainStep()
+    {
+        const auto outcome = step(_config, [](big_int &c) -> std::optional<bool> { return --c == 0; });
+        ++_plainSteps;
+        ++_stats.macroSteps;
+        if (outcome != proof_status::running)
+            _status = outcome;
+    }
+
+    /// Tries to prove a rule from `start`, which has the same shape as the current configuration and was `n` plain
+    /// macro steps ago.
+    std::optional<proof_rule> prove(const proof_config<big_int> &start, size_t n)
+    {
+        proof_config<affine_expr> general;
+        general.state = start.state;
+        general.dir = start.dir;
+        std::vector<big_int> values;
+        for (auto &&[runs, generalRuns] :
+             {std::pair{&start.left, &general.left}, std::pair{&start.right, &general.right}})
+            for (auto &&r : *runs)
+                if (r.count == 1)
+                    generalRuns->push_back({r.block, affine_expr{1}});
+                else
+                {
+                    generalRuns->push_back({r.block, affine_expr::variable(values.size())});
+                    values.push_back(r.count);
+                }
+
+        proof_rule rule;
+        rule.deltas.resize(values.size());
+        rule.mins.resize(values.size(), 1);
+        const auto takeOne = [&](affine_expr &e) -> std::optional<bool> {
+            if (e.isConstant())
+                return --e.constant == 0;
+            if (e.coeffs.size() != 1 || !e.isShiftOf(e.coeffs[0].first))
+                return {};
+            // x_i + c - 1 ≥ 1 for all allowed x_i
+            auto &min = rule.mins[e.coeffs[0].first];
+            min = std::max(min, big_int(2 - e.constant));
+            --e.constant;
+            return false;
+        };
+        for (size_t i = 0; i < n; ++i)
+            if (step(general, takeOne) != proof_status::running)
+                return {};
+
+        if (general.state != start.state || general.dir != start.dir || general.left.size() != start.left.size() ||
+            general.right.size() != start.right.size())
+            return {};
+        size_t var = 0;
+        for (auto &&[runs, generalRuns] :
+             {std::pair{&start.left, &general.left}, std::pair{&start.right, &general.right}})
+            for (size_t j = 0; j < runs->size(); ++j)
+            {
+                const auto &r = (*runs)[j];
+                const auto &g = (*generalRuns)[j];
+                if (g.block != r.block)
+                    return {};
+                if (r.count == 1)
+                {
+                    if (!g.count.isConstant() || g.count.constant != 1)
+                        return {};
+                    continue;
+                }
+                if (!g.count.isShiftOf(var))
+                    return {};
+                rule.deltas[var] = g.count.constant;
+                // The run must not disappear.
+                rule.mins[var] = std::max(rule.mins[var], big_int(1 - g.count.constant));
+                ++var;
+            }
+        for (size_t i = 0; i < values.size(); ++i)
+            if (values[i] < rule.mins[i])
+                return {};
+        rule.steps = std::move(general.steps);
+        return rule;
+    }
+
+    /// Applies a rule to the current configuration as many times as possible. Returns false if it doesn't apply.
+    bool applyRule(const proof_rule &rule)
+    {
+        std::vector<big_int *> counts;
+        for (auto &&runs : {&_config.left, &_config.right})
+            for (auto &&r : *runs)
+                if (r.count != 1)
+                    counts.push_back(&r.count);
+        assert(counts.size() == rule.deltas.size());
+        // Number of applications, or -1 for infinitely many
+        big_int k = -1;
+        for (size_t i = 0; i < counts.size(); ++i)
+        {
+            if (*counts[i] < rule.mins[i])
+                return false;
+            if (rule.deltas[i] < 0)
+            {
+                const big_int ki = (*counts[i] - rule.mins[i]) / -rule.deltas[i] + 1;
+                if (k < 0 || ki < k)
+                    k = ki;
+            }
+        }
+        ++_stats.ruleApplications;
+        _history.clear();
+        if (k < 0)
+        {
+            _status = proof_status::infinite;
+            return true;
+        }
+        // Σ_{j<k} (c + Σ a_i (x_i + j d_i)) = k c + Σ a_i (k x_i + d_i k (k - 1) / 2)
+        const big_int triangle = k * (k - 1) / 2;
+        _config.steps += k * rule.steps.constant;
+        for (auto &&[i, a] : rule.steps.coeffs)
+            _config.steps += a * (k * *counts[i] + rule.deltas[i] * triangle);
+        for (size_t i = 0; i < counts.size(); ++i)
+            *counts[i] += k * rule.deltas[i];
+        return true;
+    }
+};
+
+/// Picks a block size for `ProofTuringMachine` by running each candidate for `probeIterations` iterations. Returns the
+/// first one that decides the machine, or else the one that got furthest.
+/// @param verbose Whether to print the result of each candidate.
+inline size_t findProofBlockSize(const turing_rule &rule, size_t probeIterations = 10000, size_t maxBlockSize = 8,
+                                 bool verbose = false)
+{
+    maxBlockSize = std::min(maxBlockSize, 64 / packedBitsPerCell(rule.numSymbols()));
+    size_t best = 1;
+    big_int bestSteps = -1;
+    for (size_t k = 1; k <= maxBlockSize; ++k)
+    {
+        ProofTuringMachine m{rule, k};
+        const auto status = m.run(probeIterations);
+        if (verbose)
+            std::cout << "  k = " << k << " | steps = " << m.steps() << " | rules proven = " << m.stats().rulesProven
+                      << '\n';
+        if (status != proof_status::running)
+            return k;
+        if (m.steps() > bestSteps)
+        {
+            best = k;
+            bestSteps = m.steps();
+        }
+    }
+    return best;
+}
+} // namespace turing
@@ -0,0 +1,308 @@
+#pragma once
+
+#include "../turing.hpp"
+
+namespace turing
+{
+/// A run of identical symbols on a tape.
+struct tape_run
+{
+    symbol_type symbol = 0;
+    size_t count = 0;
+
+    constexpr friend bool operator==(const tape_run &a, const tape_run &b) = default;
+};
+
+/// A run-length-encoded Turing tape, along with a head and a state. The head cell is stored on its own; the runs to
+/// its left and right are stored in two deques, each with the run nearest the head at the front.
+class RLETape
+{
+  public:
+    using container_type = std::deque<tape_run>;
+    static constexpr size_t defaultPrintWidth = Tape::defaultPrintWidth;
+
+    constexpr symbol_type operator*() const { return _symbol; }
+
+    /// Gets the symbol at the given absolute position (zero being the initial position). Takes time linear in the
+    /// number of runs between the head and `i`.
+    [[nodiscard]] symbol_type operator[](int64_t i) const
+    {
+        if (i == _head)
+            return _symbol;
+        const auto &runs = i < _head ? _left : _right;
+        auto d = (size_t)std::abs(i - _head);
+        for (auto &&r : runs)
+        {
+            if (d <= r.count)
+                return r.symbol;
+            d -= r.count;
+        }
+        return 0;
+    }
+
+    /// The runs to the left of the head, nearest first.
+    [[nodiscard]] const container_type &left() const { return _left; }
+    /// The runs to the right of the head, nearest first.
+    [[nodiscard]] const container_type &right() const { return _right; }
+    /// Returns the absolute position of the head.
+    [[nodiscard]] constexpr int64_t head() const { return _head; }
+
+    /// The left edge of the tape.
+    [[nodiscard]] constexpr int64_t leftEdge() const { return _leftEdge; }
+    // The right edge of the tape.
+    [[nodiscard]] constexpr int64_t rightEdge() const { return _rightEdge; }
+    /// The size of the tape.
+    [[nodiscard]] constexpr size_t size() const { return rightEdge() - leftEdge() + 1; }
+    [[nodiscard]] constexpr size_t state() const { return _state; }
+
+    /// Returns whether the tape consists of all zeros.
+    [[nodiscard]] bool blank() const
+    {
+        auto isBlank = [](const tape_run &r) { return r.symbol == 0; };
+        return _symbol == 0 && std::ranges::all_of(_left, isBlank) && std::ranges::all_of(_right, isBlank);
+    }
+
+    /// The number of nonzero symbols on the tape.
+    [[nodiscard]] size_t sigma() const
+    {
+        size_t res = _symbol != 0;
+        for (auto &&runs : {&_left, &_right})
+            for (auto &&r : *runs)
+                if (r.symbol != 0)
+                    res += r.count;
+        return res;
+    }
+
+    /// Steps, and returns whether the tape expanded as a result of the step.
+    bool step(const transition &tr)
+    {
+        _state = tr.toState;
+        if (tr.direction == direction::left)
+        {
+            push(_right, tr.symbol, 1);
+            _symbol = pull(_left);
+            return moveHead(-1);
+        }
+        push(_left, tr.symbol, 1);
+        _symbol = pull(_right);
+        return moveHead(1);
+    }
+
+    /// @brief Performs a chain step: `tr` must send the machine back to its current state, so it keeps crossing
+    /// cells equal to the head cell in the same direction. Crosses the head cell and the whole adjacent run of that
+    /// symbol at once.
+    /// @param tr The transition for the current state and head symbol.
+    /// @param maxSteps The maximum number of steps to take. Must be at least 1.
+    /// @param expanded Set to whether the tape expanded.
+    /// @return The number of steps taken. If the head runs off into blank tape forever, this is `maxSteps`, unless
+    /// `maxSteps` is too large for a head position, in which case no step is taken and this is 0.
+    size_t chainStep(const transition &tr, size_t maxSteps, bool &expanded)
+    {
+        const int64_t dir = tr.direction == direction::left ? -1 : 1;
+        auto &ahead = dir < 0 ? _left : _right;
+        auto &behind = dir < 0 ? _right : _left;
+        const symbol_type s = _symbol;
+        const bool endless = ahead.empty() && s == 0;
+        if (endless && maxSteps > (size_t)std::numeric_limits<int64_t>::max())
+        {
+            expanded = false;
+            return 0;
+        }
+        // Number of cells equal to s ahead of the head.
+        const size_t n = endless ? std::numeric_limits<size_t>::max()
+                         : !ahead.empty() && ahead.front().symbol == s ? ahead.front().count
+                                                                       : 0;
+        const size_t k = n == std::numeric_limits<size_t>::max() ? n : n + 1;
+        const size_t m = std::min(k, maxSteps);
+        push(behind, tr.symbol, m);
+        if (!endless)
+        {
+            if (m < k)
+            {
+                // Stopped inside the run; the head cell is still s.
+                if ((ahead.front().count -= m) == 0)
+                    ahead.pop_front();
+            }
+            else
+            {
+                if (n > 0)
+                    ahead.pop_front();
+                _symbol = pull(ahead);
+            }
+        }
+        expanded = moveHead(dir * (int64_t)m);
+        return m;
+    }
+
+    /// Returns a string representation of this tape, with runs written as `symbol^count`.
+    [[nodiscard]] std::string str() const
+    {
+        std::string s{(char)(_state + 'A')};
+        for (auto &&r : std::views::reverse(_left))
+            s += ' ' + runStr(r);
+        s += " >";
+        s += (char)('0' + _symbol);
+        for (auto &&r : _right)
+            s += ' ' + runStr(r);
+        return s;
+    }
+
+    /// Returns a string representation of this tape, colored for the terminal.
+    [[nodiscard]] std::string prettyStr(size_t width = defaultPrintWidth) const
+    {
+        std::string s;
+        const auto headPrefix = getBgStyle(_state);
+        const auto headSuffix = ansi::str(ansi::bgDefault);
+        const int64_t shift = width / 2;
+        const int64_t start = width * floorDiv((int64_t)(_head + shift), (int64_t)width) - shift;
+        for (int64_t i = start; i < (int64_t)(start + width); ++i)
+        {
+            if (i == _head)
+                s += headPrefix;
+            s += (i >= _leftEdge && i <= rightEdge() ? (char)('0' + (*this)[i]) : ' ');
+            if (i == _head)
+                s += headSuffix;
+        }
+        return s;
+    }
+
+    /// @brief Gets the tape segment between `start` and `stop`, inclusive.
+    /// @param start The start position (inclusive).
+    /// @param stop The stop position (inclusive).
+    [[nodiscard]] tape_segment getSegment(int64_t start, int64_t stop) const
+    {
+        std::vector<symbol_type> v(size_t(stop - start + 1));
+        for (int64_t i = start; i <= stop; ++i)
+            v[i - start] = (*this)[i];
+        return {.state = _state, .data = v, .head = _head - start};
+    }
+
+    template <typename CharT, typename Traits>
+    friend std::basic_ostream<CharT, Traits> &operator<<(std::basic_ostream<CharT, Traits> &o, const RLETape &t)
+    {
+        return o << t.str();
+    }
+
+  private:
+    container_type _left;
+    container_type _right;
+    symbol_type _symbol = 0;
+    int64_t _head = 0;
+    int64_t _leftEdge = 0;
+    int64_t _rightEdge = 0;
+    state_type _state = 0;
+
+    static void push(container_type &runs, symbol_type symbol, size_t count)
+    {
+        if (!runs.empty() && runs.front().symbol == symbol)
+            runs.front().count += count;
+        else
+            runs.push_front({.symbol = symbol, .count = count});
+    }
+
+    static symbol_type pull(container_type &runs)
+    {
+        if (runs.empty())
+            return 0;
+        auto symbol = runs.front().symbol;
+        if (--runs.front().count == 0)
+            runs.pop_front();
+        return symbol;
+    }
+
+    /// Moves the head by `delta` and returns whether the tape expanded.
+    constexpr bool moveHead(int64_t delta)
+    {
+        _head += delta;
+        if (_head < _leftEdge)
+        {
+            _leftEdge = _head;
+            return true;
+        }
+        if (_head > _rightEdge)
+        {
+            _rightEdge = _head;
+            return true;
+        }
+        return false;
+    }
+
+    static std::string runStr(const tape_run &r)
+    {
+        std::string s{(char)('0' + r.symbol)};
+        if (r.count > 1)
+            s += '^' + std::to_string(r.count);
+        return s;
+    }
+};
+
+/// A Turing machine on a run-length-encoded tape. Whenever the next transition sends the machine back to the same
+/// state, the machine crosses the whole run under the head in one step, so long sweeps cost O(1).
+class RLETuringMachine
+{
+  public:
+    using tape_type = RLETape;
+    using step_result = TuringMachine::step_result;
+
+    RLETuringMachine(turing_rule rule = {}, size_t steps = 0) : _rule(rule), _steps(steps) {}
+
+    /// Initializes a Turing machine from a code in TNF format.
+    RLETuringMachine(std::string code, size_t steps = 0) : _rule(std::move(code)), _steps(steps) {}
+
+    [[nodiscard]] constexpr size_t numStates() const { return _rule.numStates(); }
+    [[nodiscard]] constexpr size_t numColors() const { return _rule.numSymbols(); }
+
+    [[nodiscard]] constexpr const turing_rule &rule() const { return _rule; }
+    [[nodiscard]] std::string ruleStr() const { return _rule.str(); }
+    [[nodiscard]] constexpr const RLETape &tape() const { return _tape; }
+    [[nodiscard]] constexpr size_t steps() const { return _steps; }
+    [[nodiscard]] constexpr state_type state() const { return (state_type)_tape.state(); }
+
+    /// Returns whether the Turing machine is halted, i.e. in the Z state.
+    [[nodiscard]] constexpr bool halted() const { return state() < 0 || (size_t)state() >= numStates(); }
+    [[nodiscard]] bool blank() const { return _tape.blank(); }
+
+    [[nodiscard]] constexpr int64_t head() const { return _tape.head(); }
+
+    /// Gets the transition that this machine will execute next.
+    [[nodiscard]] constexpr const transition &peek() const { return _rule[state(), *_tape]; }
+
+    /// Takes one step, or a whole chain step of at most `maxSteps` steps if the next transition loops back to the
+    /// current state. A chain into blank tape never ends, so it fails without a step unless `maxSteps` is less than
+    /// 2^63.
+    step_result step(size_t maxSteps)
+    {
+        if (halted() || maxSteps == 0)
+            return {.success = false, .tapeExpanded = false};
+        const auto &tr = peek();
+        if (tr.toState != state())
+        {
+            ++_steps;
+            return {.success = true, .tapeExpanded = _tape.step(tr)};
+        }
+        bool expanded = false;
+        const size_t n = _tape.chainStep(tr, maxSteps, expanded);
+        _steps += n;
+        return {.success = n > 0, .tapeExpanded = expanded};
+    }
+
+    /// Seeks forward to step number n, or until the machine halts or a step fails (see `step`).
+    void seek(size_t n)
+    {
+        while (_steps < n)
+            if (!step(n - _steps).success)
+                break;
+    }
+
+    [[nodiscard]] std::string str() const { return _tape.str(); }
+    [[nodiscard]] std::string prettyStr(size_t width = RLETape::defaultPrintWidth) const
+    {
+        return _tape.prettyStr(width);
+    }
+
+  private:
+    turing_rule _rule;
+    RLETape _tape;
+    size_t _steps = 0;
+};
+} // namespace turing
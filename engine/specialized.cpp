@@ -0,0 +1,85 @@
+// Simulators specialized at compile time for a fixed list of Turing machines. The list is set by the CMake variable
+// SPECIALIZED_MACHINES, which defaults to the machines in turing::known.
+
+#include "../pch.hpp"
+
+#include "specialized.hpp"
+#include "specialized_machines.hpp"
+
+using namespace std;
+using namespace turing;
+
+template <rule_string Code> auto run(size_t numSteps)
+{
+    SpecializedTuringMachine<Code> m;
+    m.seek(numSteps);
+    return pair{m.steps(), m.tape()};
+}
+
+int main(int argc, char *argv[])
+{
+    constexpr string_view help = R"(Simulates a Turing machine with a simulator specialized at compile time, and outputs
+the final tape
+
+Usage: ./specialized <TM> <n>
+
+Arguments:
+  <TM>  The Turing machine. Must be one of the machines this program was built
+        for (see --list)
+  <n>   Number of steps
+
+Options:
+  -h, --help  Show this help message
+  -l, --list  List the machines this program was built for
+)";
+    const span args(argv, argc);
+    string_view code;
+    size_t numSteps = 0;
+    int argPos = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(args[i], "-h") == 0 || strcmp(args[i], "--help") == 0)
+        {
+            cout << help;
+            return 0;
+        }
+        if (strcmp(args[i], "-l") == 0 || strcmp(args[i], "--list") == 0)
+        {
+#define X(tm) cout << tm << '\n';
+            SPECIALIZED_MACHINES(X)
+#undef X
+            return 0;
+        }
+        if (argPos == 0)
+        {
+            ++argPos;
+            code = args[i];
+        }
+        else if (argPos == 1)
+        {
+            ++argPos;
+            numSteps = parseNumber(args[i]);
+        }
+        else
+        {
+            cerr << ansi::red << "Unexpected argument: " << ansi::reset << args[i] << '\n' << help;
+            return 0;
+        }
+    }
+    if (code.empty())
+    {
+        cout << help;
+        return 0;
+    }
+    ios::sync_with_stdio(false);
+#define X(tm)                                                                                                          \
+    if (code == tm)                                                                                                    \
+    {                                                                                                                  \
+        printTiming(run<tm>, numSteps);                                                                                \
+        return 0;                                                                                                      \
+    }
+    SPECIALIZED_MACHINES(X)
+#undef X
+    cerr << ansi::red << "Not built for this machine: " << ansi::reset << code
+         << "\nAdd it to SPECIALIZED_MACHINES in CMake and rebuild.\n";
+}
@@ -0,0 +1,146 @@
+#pragma once
+
+#include "../turing.hpp"
+
+#if defined(__clang__)
+/// Continues in the code for state `S`. With clang, this is a guaranteed tail call, so each state's code jumps straight
+/// to the next like a goto. Otherwise it returns to `SpecializedTuringMachine::dispatch`.
+#define TURING_GOTO_STATE(S) [[clang::musttail]] return runState<S>(c)
+#else
+#define TURING_GOTO_STATE(S) return S
+#endif
+
+namespace turing
+{
+/// A Turing machine code usable as a template argument, e.g. `SpecializedTuringMachine<"1RB1LB_1LA1RZ">`.
+template <size_t N> struct rule_string
+{
+    char data[N]{};
+
+    constexpr rule_string(const char (&s)[N]) { std::copy_n(s, N, data); }
+
+    [[nodiscard]] constexpr std::string_view view() const { return {data, N - 1}; }
+};
+
+/// A Turing machine whose rule is known at compile time. Each state is compiled to its own function; transitions
+/// that loop back to the same state become an inner while loop, and other transitions jump directly to the code of
+/// the next state. This is the automatic version of hand-lowering a machine to nested loops.
+template <rule_string Code> class SpecializedTuringMachine
+{
+  public:
+    static constexpr turing_rule rule = turing_rule::parse(Code.view());
+    static_assert(!rule.empty(), "Invalid Turing machine code");
+
+    [[nodiscard]] static constexpr size_t numStates() { return rule.numStates(); }
+    [[nodiscard]] static constexpr size_t numColors() { return rule.numSymbols(); }
+    [[nodiscard]] static constexpr std::string_view ruleStr() { return Code.view(); }
+
+    [[nodiscard]] constexpr const Tape &tape() const { return _c.tape; }
+    [[nodiscard]] constexpr size_t steps() const { return _c.steps; }
+    [[nodiscard]] constexpr state_type state() const { return _state; }
+    /// Returns whether the Turing machine is halted, i.e. in the Z state.
+    [[nodiscard]] constexpr bool halted() const { return isHalt(_state); }
+    [[nodiscard]] constexpr int64_t head() const { return _c.tape.head(); }
+
+    /// Seeks forward to step number n, or until the machine halts.
+    void seek(size_t n)
+    {
+        _c.maxSteps = n;
+        while (!halted() && _c.steps < n)
+            _state = dispatch(_state, _c);
+    }
+
+    [[nodiscard]] std::string str() const { return _c.tape.str(); }
+    [[nodiscard]] std::string prettyStr(size_t width = Tape::defaultPrintWidth) const
+    {
+        return _c.tape.prettyStr(width);
+    }
+
+  private:
+    struct context
+    {
+        Tape tape;
+        size_t steps = 0;
+        size_t maxSteps = 0;
+    };
+
+    context _c;
+    state_type _state = 0;
+
+    static constexpr bool isHalt(state_type s) { return s < 0 || (size_t)s >= rule.numStates(); }
+
+    /// Bit mask of the symbols on which state `S` loops back to itself.
+    template <state_type S>
+    static constexpr unsigned selfLoops = [] {
+        unsigned mask = 0;
+        for (size_t j = 0; j < rule.numSymbols(); ++j)
+            if (rule[S, j].toState == S)
+                mask |= 1U << j;
+        return mask;
+    }();
+
+    /// The state that state `S` goes to on symbol `J`.
+    template <state_type S, symbol_type J>
+    static constexpr state_type target = J < rule.numSymbols() ? rule[S, J].toState : (state_type)-1;
+
+    /// Runs from state `S` until the step budget runs out or the machine halts, and returns the state it stopped in.
+    /// Without guaranteed tail calls, returns after each transition out of `S` instead.
+    template <state_type S> static state_type runState(context &c)
+    {
+        if constexpr (isHalt(S))
+            return S;
+        else
+        {
+            if constexpr (selfLoops<S> != 0)
+                while (c.steps < c.maxSteps && ((selfLoops<S> >> *c.tape) & 1) != 0)
+                {
+                    c.tape.step(rule[S, *c.tape]);
+                    ++c.steps;
+                }
+            if (c.steps == c.maxSteps)
+                return S;
+            const symbol_type symbol = *c.tape;
+            c.tape.step(rule[S, symbol]);
+            ++c.steps;
+            switch (symbol)
+            {
+            case 0:
+                TURING_GOTO_STATE((target<S, 0>));
+            case 1:
+                TURING_GOTO_STATE((target<S, 1>));
+            case 2:
+                TURING_GOTO_STATE((target<S, 2>));
+            case 3:
+                TURING_GOTO_STATE((target<S, 3>));
+            case 4:
+                TURING_GOTO_STATE((target<S, 4>));
+            default:
+                TURING_GOTO_STATE((target<S, 5>));
+            }
+        }
+    }
+
+    static state_type dispatch(state_type s, context &c)
+    {
+        switch (s)
+        {
+        case 0:
+            return runState<0>(c);
+        case 1:
+            return runState<1>(c);
+        case 2:
+            return runState<2>(c);
+        case 3:
+            return runState<3>(c);
+        case 4:
+            return runState<4>(c);
+        case 5:
+            return runState<5>(c);
+        default:
+            return s;
+        }
+    }
+};
+} // namespace turing
+
+#undef TURING_GOTO_STATE
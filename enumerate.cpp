@@ -1,7 +1,18 @@
 #include "pch.hpp"
 
+#include "arena.hpp"
 #include "decide/bouncer.hpp"
+#include "decide/brent_cycler.hpp"
+#include "decide/far.hpp"
 #include "decide/tcycler.hpp"
+#include "seeds.hpp"
+#include "snapshot.hpp"
+#include "telemetry.hpp"
+
+#include <tbb/blocked_range.h>
+#include <tbb/info.h>
+#include <tbb/parallel_for.h>
+#include <tbb/task_arena.h>
 
 using namespace std;
 using namespace turing;
@@ -77,239 +88,1032 @@ constexpr size_t interestingTCCutoff(int nStates, int nSymbols)
     return 5000;
 }
 
-template <typename Callback> bool enumTMs(int nStates, int nSymbols, size_t maxSteps, Callback f)
+/// A node of the Brady tree: a machine whose next transition is undefined, along with the highest symbol and state
+/// used so far.
+template <typename Machine> using basic_enum_node = tuple<Machine, symbol_type, state_type>;
+using enum_node = basic_enum_node<TuringMachine>;
+
+template <typename Machine> bool nextIsHalt(const Machine &m) { return m.peek().toState == -1; }
+
+/// The root of the Brady tree, whose only transition is A0 → 1RB.
+inline enum_node enumRoot(int nStates, int nSymbols)
 {
-    auto nextIsHalt = [](const TuringMachine &m) { return m.peek().toState == -1; };
     turing_rule r(nStates, nSymbols);
     r[0, 0] = {.symbol = 1, .direction = direction::right, .toState = 1};
     TuringMachine root{r};
     root.step();
+    return {root, (symbol_type)1, (state_type)1};
+}
+
+/// Returns whether the children of this node are enumerated.
+template <typename Machine> bool enumExpands(const basic_enum_node<Machine> &t, size_t maxSteps)
+{
+    auto &&[m, hSymbol, hState] = t;
+    return m.steps() < maxSteps && !m.rule().filled();
+}
+
+/// Returns whether this node is an enumerated machine.
+template <typename Machine>
+bool enumIsLeaf(const basic_enum_node<Machine> &t, int nStates, int nSymbols, size_t maxSteps)
+{
+    auto &&[m, hSymbol, hState] = t;
+    return !nextIsHalt(m) &&
+           (m.rule().filled() || (m.steps() == maxSteps && hSymbol == nSymbols - 1 && hState == nStates - 1));
+}
+
+/// Calls `f` on each child of the node, in order: the node's machine with its undefined transition filled in, run to
+/// its next undefined transition. Returns false if `f` asked to stop.
+template <typename Machine, typename Callback>
+bool enumChildren(const basic_enum_node<Machine> &t, int nStates, int nSymbols, size_t maxSteps, Callback f)
+{
+    auto &&[m, hSymbol, hState] = t;
+    // Invariant: m's next state should be a halt state.
+    if (nextIsHalt(m))
+    {
+        for (symbol_type symbol = 0; symbol <= min(nSymbols - 1, hSymbol + 1); ++symbol)
+            for (auto dir : {direction::left, direction::right})
+                for (state_type state = 0; state <= min(nStates - 1, hState + 1); ++state)
+                {
+                    auto r = m.rule();
+                    r[m.state(), *m.tape()] = {symbol, dir, state};
+                    Machine m2{std::move(r), m.tape(), m.steps()};
+                    if (!m2.rule().filled())
+                        while (m2.steps() < maxSteps && !nextIsHalt(m2))
+                            m2.step();
+                    if (!it::callbackResult(
+                            f, basic_enum_node<Machine>{std::move(m2), max(hSymbol, symbol), max(hState, state)}))
+                        return false;
+                }
+    }
+    return true;
+}
+
+/// Enumerates the machines in the subtree of the Brady tree rooted at `root`, in preorder. The nodes are copied into
+/// the arena, which is rewound when the subtree of each node is done, so `f` must not keep the machines.
+template <typename Callback>
+bool enumTMs(const enum_node &root, Arena &arena, int nStates, int nSymbols, size_t maxSteps, Callback f)
+{
+    const ArenaScope scope{arena};
+    auto &&[m, hSymbol, hState] = root;
     return it::tree_preorder(
-        tuple{root, (symbol_type)1, (state_type)1},
+        basic_enum_node<ArenaTuringMachine>{ArenaTuringMachine{m.rule(), ArenaTape{m.tape()}, m.steps()}, hSymbol,
+                                            hState},
         [&](auto &&t, auto rec) {
-            auto &&[m, hSymbol, hState] = t;
-            // Invariant: m's next state should be a halt state.
-            if (nextIsHalt(m))
-            {
-                for (symbol_type symbol = 0; symbol <= min(nSymbols - 1, hSymbol + 1); ++symbol)
-                    for (auto dir : {direction::left, direction::right})
-                        for (state_type state = 0; state <= min(nStates - 1, hState + 1); ++state)
-                        {
-                            auto r = m.rule();
-                            r[m.state(), *m.tape()] = {symbol, dir, state};
-                            TuringMachine m2{std::move(r), m.tape(), m.steps()};
-                            if (!m2.rule().filled())
-                                while (m2.steps() < maxSteps && !nextIsHalt(m2))
-                                    m2.step();
-                            if (!it::callbackResult(rec,
-                                                    tuple{std::move(m2), max(hSymbol, symbol), max(hState, state)}))
-                                return it::result_break;
-                        }
-            }
-            return it::result_continue;
+            const bool more = enumChildren(t, nStates, nSymbols, maxSteps, [&](auto &&child) {
+                const ArenaScope childScope{arena};
+                return rec(std::forward<decltype(child)>(child));
+            });
+            return more ? it::result_continue : it::result_break;
         },
-        [&](auto &&t) {
-            auto &&[m, hSymbol, hState] = t;
-            return m.steps() < maxSteps && !m.rule().filled();
-        })([&](auto &&t) {
-        auto &&[m, hSymbol, hState] = t;
-        if (!nextIsHalt(m) &&
-            (m.rule().filled() || (m.steps() == maxSteps && hSymbol == nSymbols - 1 && hState == nStates - 1)))
-            if (!it::callbackResult(f, m))
+        [&](auto &&t) { return enumExpands(t, maxSteps); })([&](auto &&t) {
+        if (enumIsLeaf(t, nStates, nSymbols, maxSteps))
+            if (!it::callbackResult(f, get<0>(t)))
                 return it::result_break;
         return it::result_continue;
     });
 }
 
-struct enumerate_info
+template <typename Callback> bool enumTMs(int nStates, int nSymbols, size_t maxSteps, Callback f)
+{
+    Arena arena;
+    return enumTMs(enumRoot(nStates, nSymbols), arena, nStates, nSymbols, maxSteps, f);
+}
+
+/// Splits the given pieces of the Brady tree into at least `minPieces` subtrees if it can, by expanding every node of
+/// the frontier one level at a time. Enumerating the subtrees in order enumerates the same machines as the pieces, in
+/// the same order.
+inline vector<enum_node> enumSplit(vector<enum_node> pieces, int nStates, int nSymbols, size_t maxSteps,
+                                   size_t minPieces)
+{
+    bool expanded = true;
+    while (pieces.size() < minPieces && expanded)
+    {
+        expanded = false;
+        vector<enum_node> next;
+        for (auto &&t : pieces)
+            if (enumExpands(t, maxSteps))
+            {
+                expanded = true;
+                enumChildren(t, nStates, nSymbols, maxSteps,
+                             [&](enum_node child) { next.push_back(std::move(child)); });
+            }
+            else
+                next.push_back(std::move(t));
+        pieces = std::move(next);
+    }
+    return pieces;
+}
+
+inline vector<enum_node> enumSplit(int nStates, int nSymbols, size_t maxSteps, size_t minPieces)
+{
+    return enumSplit({enumRoot(nStates, nSymbols)}, nStates, nSymbols, maxSteps, minPieces);
+}
+
+const vector<string> names(seeds::categories.begin(), seeds::categories.end());
+
+/// The output files of an enumeration: a text file for each category, or a seed database if `binary` is true.
+class enumerate_output
+{
+  public:
+    /// If `sizes` is given, the files are truncated to those sizes and appended to, to continue an interrupted run.
+    enumerate_output(const string &directory, bool binary,
+                     const boost::unordered_flat_map<string, uint64_t> *sizes = nullptr)
+        : _binary(binary)
+    {
+        const auto open = [&](const string &fileName, ios::openmode mode) -> ofstream & {
+            const auto path = directory + fileName;
+            auto &file = _files[fileName];
+            if (sizes != nullptr)
+            {
+                error_code ec;
+                filesystem::resize_file(path, sizes->contains(fileName) ? sizes->at(fileName) : 0, ec);
+                file.open(path, mode | ios::app);
+            }
+            else
+                file.open(path, mode | ios::trunc);
+            return file;
+        };
+        if (binary)
+        {
+            auto &file = open("seeds.bin", ios::binary);
+            if (sizes == nullptr)
+                seeds::writeHeader(file);
+        }
+        else
+            for (auto &&name : names)
+                open(name + ".txt", {});
+    }
+
+    void write(const seeds::seed_record &r)
+    {
+        if (_binary)
+            seeds::write(_files["seeds.bin"], r);
+        else
+            _files[string(r.categoryName()) + ".txt"] << r.str() << '\n';
+    }
+
+    /// Flushes the files and returns their sizes.
+    boost::unordered_flat_map<string, uint64_t> sizes()
+    {
+        boost::unordered_flat_map<string, uint64_t> res;
+        for (auto &&[fileName, file] : _files)
+        {
+            file.flush();
+            res[fileName] = file.tellp();
+        }
+        return res;
+    }
+
+  private:
+    bool _binary;
+    boost::unordered_flat_map<string, ofstream> _files;
+};
+
+/// The state of an enumeration between two pieces: the totals and the sizes of the category files after the pieces
+/// committed so far, and the pieces that are left. It is saved periodically, so that an interrupted run can be resumed
+/// with `--resume`.
+///
+/// The format is little-endian binary, hashed like a snapshot:
+///
+///     magic "TMENUM" | version u8 | # states u8 | # symbols u8 | max steps u64 | simulation steps u64 | binary u8
+///     total u64 | for each category: count u64
+///     number of files u64 | files of (name length u16, name, size u64)
+///     number of pieces u64 | pieces of (highest symbol u8, highest state i8, snapshot length u64, snapshot)
+struct enumerate_checkpoint
 {
-    ofstream fout;
-    size_t count = 0;
+    int nStates = 0;
+    int nSymbols = 0;
+    size_t maxSteps = 0;
+    size_t simulationSteps = 0;
+    bool binary = false;
+    size_t total = 0;
+    boost::unordered_flat_map<string, size_t> counts;
+    /// Sizes of the output files by file name
+    boost::unordered_flat_map<string, uint64_t> fileSizes;
+    vector<enum_node> pieces;
 };
 
-size_t total = 0;
-vector<string> names{"cyclers",       "tcyclers", "bouncers", "cubic bells", "quartic bells",
-                     "quintic bells", "bells",    "counters", "unclassified"};
-boost::unordered_flat_map<string, enumerate_info> enumData;
-// vector stats(1000, 0UZ);
+constexpr string_view checkpointMagic = "TMENUM";
+/// Version 3 added the far category, and with it a count.
+constexpr uint8_t checkpointVersion = 3;
 
-inline bool cycler(TuringMachine &m, size_t maxSteps, size_t startPeriodBound, size_t printCutoff)
+/// Writes the checkpoint to `path` with `snapshot::writeFileAtomically`, so a crash never leaves a partially written
+/// checkpoint behind. Throws `std::runtime_error` on I/O errors.
+void saveCheckpoint(const enumerate_checkpoint &c, const filesystem::path &path)
+{
+    snapshot::writer w;
+    w.putBytes(checkpointMagic);
+    w.put(checkpointVersion);
+    w.put((uint8_t)c.nStates);
+    w.put((uint8_t)c.nSymbols);
+    w.put((uint64_t)c.maxSteps);
+    w.put((uint64_t)c.simulationSteps);
+    w.put((uint8_t)c.binary);
+    w.put((uint64_t)c.total);
+    for (auto &&name : names)
+        w.put((uint64_t)(c.counts.contains(name) ? c.counts.at(name) : 0));
+    w.put((uint64_t)c.fileSizes.size());
+    for (auto &&[fileName, size] : c.fileSizes)
+    {
+        w.put((uint16_t)fileName.size());
+        w.putBytes(fileName);
+        w.put(size);
+    }
+    w.put((uint64_t)c.pieces.size());
+    for (auto &&[m, hSymbol, hState] : c.pieces)
+    {
+        const auto bytes = snapshot::encode(m);
+        w.put(hSymbol);
+        w.put(hState);
+        w.put((uint64_t)bytes.size());
+        w.putBytes(bytes);
+    }
+    snapshot::writeFileAtomically(path, std::move(w).finish(), "checkpoint");
+}
+
+/// Reads a checkpoint written by `saveCheckpoint`. Throws `std::runtime_error` if the file can't be read or is not a
+/// valid checkpoint.
+enumerate_checkpoint loadCheckpoint(const filesystem::path &path)
+{
+    ifstream fin(path, ios::binary);
+    if (!fin)
+        throw runtime_error("Failed to open checkpoint " + path.string());
+    const string bytes{istreambuf_iterator<char>(fin), {}};
+    snapshot::reader r{bytes};
+    if (r.getBytes(checkpointMagic.size()) != checkpointMagic)
+        throw runtime_error("Not a checkpoint: " + path.string());
+    if (const auto v = r.get<uint8_t>(); v != checkpointVersion)
+        throw runtime_error("Unsupported checkpoint version " + to_string(v));
+    enumerate_checkpoint c;
+    c.nStates = r.get<uint8_t>();
+    c.nSymbols = r.get<uint8_t>();
+    c.maxSteps = r.get<uint64_t>();
+    c.simulationSteps = r.get<uint64_t>();
+    c.binary = r.get<uint8_t>() != 0;
+    c.total = r.get<uint64_t>();
+    for (auto &&name : names)
+        c.counts[name] = r.get<uint64_t>();
+    for (auto n = r.get<uint64_t>(); n > 0; --n)
+    {
+        const string fileName{r.getBytes(r.get<uint16_t>())};
+        c.fileSizes[fileName] = r.get<uint64_t>();
+    }
+    for (auto n = r.get<uint64_t>(); n > 0; --n)
+    {
+        const auto hSymbol = r.get<symbol_type>();
+        const auto hState = r.get<state_type>();
+        auto m = snapshot::decode(r.getBytes(r.get<uint64_t>()));
+        c.pieces.emplace_back(std::move(m), hSymbol, hState);
+    }
+    r.finish();
+    return c;
+}
+
+/// Statistics of a stage of the decider pipeline.
+struct stage_stats
+{
+    size_t calls = 0;
+    size_t hits = 0;
+    /// Total time spent in the stage.
+    uint64_t nanoseconds = 0;
+    /// Total number of steps that the stage simulated.
+    uint64_t steps = 0;
+
+    stage_stats &operator+=(const stage_stats &other)
+    {
+        calls += other.calls;
+        hits += other.hits;
+        nanoseconds += other.nanoseconds;
+        steps += other.steps;
+        return *this;
+    }
+
+    /// The hit rate divided by the mean cost. For stages that claim disjoint sets of machines, running them in order of
+    /// decreasing priority minimizes the expected time per machine. Smoothed so that stages that haven't run yet keep
+    /// their place.
+    [[nodiscard]] double priority() const
+    {
+        const double hitRate = (hits + 1.0) / (calls + 2.0);
+        const double meanCost = (nanoseconds + 1000.0) / (calls + 1.0);
+        return hitRate / meanCost;
+    }
+};
+
+/// Classification results of one piece of the enumeration. Pieces are classified in parallel and committed in
+/// enumeration order, so the output is the same as that of a serial run.
+struct enumerate_shard
+{
+    /// Number of machines classified so far.
+    size_t total = 0;
+    boost::unordered_flat_map<string, size_t> counts;
+    /// Machines to write out, numbered within the shard.
+    vector<seeds::seed_record> records;
+    /// Statistics of the decider stages.
+    vector<stage_stats> stages;
+    /// Number of steps simulated by the deciders, which the pipeline counts towards the stage that ran them.
+    uint64_t steps = 0;
+
+    /// Counts the current machine in the given category.
+    void add(const string &name) { ++counts[name]; }
+
+    /// Counts the current machine in the given category, and writes it out along with the decider's parameters.
+    template <typename... Args> void add(const string &name, const turing_rule &rule, const Args &...fields)
+    {
+        ++counts[name];
+        auto &r = records.emplace_back(seeds::seed_record::make(total, seeds::category(name), rule));
+        (r.add(fields), ...);
+    }
+};
+
+/// A machine being classified. The bouncer decider keeps its session here, so that the later stages continue its
+/// simulation instead of starting over.
+struct candidate
+{
+    ArenaTuringMachine m;
+    optional<bouncer_session<ArenaTuringMachine>> bouncer;
+};
+
+/// A stage of the decider pipeline.
+struct decider_stage
+{
+    string name;
+    /// Stages that must run before this one, because a machine that both would classify must go to them. The other
+    /// stages claim disjoint sets of machines, so reordering them doesn't change the results.
+    vector<size_t> after;
+    /// Classifies the machine and returns true, or returns false if the stage doesn't apply.
+    function<bool(candidate &, enumerate_shard &)> decide;
+};
+
+/// Orders the stages by decreasing priority, subject to their `after` constraints. Ties keep the order of `stages`.
+inline vector<size_t> pipelineOrder(const vector<decider_stage> &stages, const vector<stage_stats> &stats)
+{
+    vector<size_t> order;
+    vector<bool> placed(stages.size());
+    while (order.size() < stages.size())
+    {
+        size_t best = stages.size();
+        for (size_t i = 0; i < stages.size(); ++i)
+            if (!placed[i] && ranges::all_of(stages[i].after, [&](size_t j) { return placed[j]; }) &&
+                (best == stages.size() || stats[i].priority() > stats[best].priority()))
+                best = i;
+        placed[best] = true;
+        order.push_back(best);
+    }
+    return order;
+}
+
+inline bool cycler(ArenaTuringMachine &m, enumerate_shard &out, size_t maxSteps, size_t startPeriodBound,
+                   size_t printCutoff)
 {
     auto res = CyclerDecider{}.find(m, maxSteps, startPeriodBound);
+    out.steps += res.steps;
     if (res.period > 0)
     {
-        ++enumData["cyclers"].count;
         if (res.preperiod >= printCutoff || res.period >= printCutoff)
-            enumData["cyclers"].fout << setw(8) << total << '\t' << lexicalNormalForm(m.rule()).str() << '\t'
-                                     << res.period << '\t' << res.preperiod << '\n';
+            out.add("cyclers", lexicalNormalForm(m.rule()), res.period, res.preperiod);
+        else
+            out.add("cyclers");
         return true;
     }
     return false;
 }
 
-inline bool cyclerFast(TuringMachine &m, size_t maxSteps, size_t startPeriodBound)
+inline bool cyclerFast(ArenaTuringMachine &m, enumerate_shard &out, size_t maxSteps, size_t startPeriodBound)
 {
-    auto res = CyclerDecider{}.findPeriodOnly(m, maxSteps, startPeriodBound);
+    // The laps of `CyclerDecider`, so that it finds the same cyclers
+    auto res = BrentCyclerDecider{periodGrowthRatio}.findPeriodOnly(m, maxSteps, startPeriodBound);
+    out.steps += res.steps;
     if (res.period > 0)
     {
-        ++enumData["cyclers"].count;
+        out.add("cyclers");
         return true;
     }
     return false;
 }
 
-inline bool tc(TuringMachine &m, size_t maxSteps, size_t startPeriodBound, size_t printCutoff)
+inline bool tc(ArenaTuringMachine &m, enumerate_shard &out, size_t maxSteps, size_t startPeriodBound,
+               size_t printCutoff)
 {
     auto res = TranslatedCyclerDecider{}.find(m, maxSteps, startPeriodBound);
+    out.steps += res.steps;
     if (res.period > 0)
     {
-        ++enumData["tcyclers"].count;
         if (res.period >= printCutoff || res.preperiod >= printCutoff)
-            enumData["tcyclers"].fout << setw(8) << total << '\t' << lexicalNormalForm(m.rule()).str() << '\t'
-                                      << res.period << '\t' << res.preperiod << '\t' << res.offset << '\n';
+            out.add("tcyclers", lexicalNormalForm(m.rule()), res.period, res.preperiod, res.offset);
+        else
+            out.add("tcyclers");
         return true;
     }
     return false;
 }
 
-inline bool tcFast(TuringMachine &m, size_t maxSteps, size_t startPeriodBound)
+inline bool tcFast(ArenaTuringMachine &m, enumerate_shard &out, size_t maxSteps, size_t startPeriodBound)
 {
     auto res = TranslatedCyclerDecider{}.findPeriodOnly(m, maxSteps, startPeriodBound);
+    out.steps += res.steps;
     if (res.period > 0)
     {
-        ++enumData["tcyclers"].count;
+        out.add("tcyclers");
         return true;
     }
     return false;
 }
 
-inline bool bouncer(TuringMachine &m, size_t degree, size_t maxSteps, size_t maxPeriod, size_t confidenceLevel,
-                    auto &&printFilter)
+inline bool bouncer(candidate &c, enumerate_shard &out, size_t degree, size_t maxSteps, size_t maxPeriod,
+                    size_t confidenceLevel, auto &&printFilter)
 {
-    auto res = BouncerDecider{}.find(m, degree, maxSteps, maxPeriod, confidenceLevel);
+    const BouncerDecider decider;
+    auto &s = c.bouncer.emplace(decider.session(c.m));
+    auto res = decider.extend(s, degree, maxSteps, maxPeriod, confidenceLevel);
+    out.steps += s.m.steps() - c.m.steps();
     if (res.found)
     {
+        const auto code = lexicalNormalForm(c.m.rule());
         if (res.degree == 1)
-        {
-            ++enumData["tcyclers"].count;
-            enumData["tcyclers"].fout << setw(8) << total << '\t' << lexicalNormalForm(m.rule()).str() << '\t' << "?"
-                                      << '\t' << res.start << '\t' << res.xPeriod << '\n';
-        }
+            out.add("tcyclers", code, seeds::unknown, res.start, res.xPeriod);
         else if (res.degree == 2)
         {
-            // Check for bell or fake bouncer
-            auto res2 = BouncerDecider{}.find(m, 2, 4 * maxSteps, res.xPeriod, 3 * confidenceLevel);
+            // Check for bell or fake bouncer, continuing the same simulation
+            const size_t steps = s.m.steps();
+            auto res2 = decider.extend(s, 2, 4 * maxSteps, res.xPeriod, 3 * confidenceLevel);
+            out.steps += s.m.steps() - steps;
             if (res2.start != res.start || res2.xPeriod != res.xPeriod)
-            {
-                ++enumData["bells"].count;
-                enumData["bells"].fout << setw(8) << total << '\t' << lexicalNormalForm(m.rule()).str() << '\n';
-            }
+                out.add("bells", code);
+            else if (printFilter(res))
+                out.add("bouncers", code, res.start, res.xPeriod);
             else
-            {
-                ++enumData["bouncers"].count;
-                if (printFilter(res))
-                    enumData["bouncers"].fout << setw(8) << total << '\t' << lexicalNormalForm(m.rule()).str() << '\t'
-                                              << res.start << '\t' << res.xPeriod << '\n';
-            }
+                out.add("bouncers");
         }
         else if (res.degree == 3)
         {
-            ++enumData["cubic bells"].count;
             if (printFilter(res))
-                enumData["cubic bells"].fout << setw(8) << total << '\t' << lexicalNormalForm(m.rule()).str() << '\t'
-                                             << res.start << '\t' << res.xPeriod << '\n';
+                out.add("cubic bells", code, res.start, res.xPeriod);
+            else
+                out.add("cubic bells");
         }
         else if (res.degree == 4)
-        {
-            ++enumData["quartic bells"].count;
-            enumData["quartic bells"].fout << setw(8) << total << '\t' << lexicalNormalForm(m.rule()).str() << '\t'
-                                           << res.degree << '\t' << res.start << '\t' << res.xPeriod << '\n';
-        }
+            out.add("quartic bells", code, res.degree, res.start, res.xPeriod);
         else
-        {
-            ++enumData["quintic bells"].count;
-            enumData["quintic bells"].fout << setw(8) << total << '\t' << lexicalNormalForm(m.rule()).str() << '\t'
-                                           << res.degree << '\t' << res.start << '\t' << res.xPeriod << '\n';
-        }
+            out.add("quintic bells", code, res.degree, res.start, res.xPeriod);
         return true;
     }
     return false;
 }
 
-inline bool counter(TuringMachine &m, size_t simulationSteps)
+/// Proves that a machine with an undefined transition never reaches one. Machines without one never halt anyway, and
+/// are left to the other deciders to classify by their behavior.
+inline bool far(ArenaTuringMachine &m, enumerate_shard &out, size_t maxDfaStates, size_t maxNodes)
+{
+    if (m.rule().filled())
+        return false;
+    const auto res = FarDecider{}.find(m.rule(), maxDfaStates, maxNodes);
+    if (res.found)
+    {
+        out.add("far", lexicalNormalForm(m.rule()), res.dfa.numStates(), res.mirrored);
+        return true;
+    }
+    return false;
+}
+
+/// Leaves the machine where the simulation stopped.
+inline bool counter(candidate &c, enumerate_shard &out, size_t simulationSteps)
 {
     if (simulationSteps > 0)
     {
         const size_t tapeSizeBound = 25 * log10(simulationSteps);
-        for (size_t i = 0; i < simulationSteps; ++i)
+        auto &m = c.m;
+        // Continue from the bouncer decider's simulation, unless it went past the point where this one stops
+        if (c.bouncer && c.bouncer->m.steps() <= simulationSteps && c.bouncer->m.tape().size() <= tapeSizeBound)
+        {
+            m = std::move(c.bouncer->m);
+            c.bouncer.reset();
+        }
+        const size_t steps = m.steps();
+        for (size_t i = m.steps(); i < simulationSteps; ++i)
         {
             m.step();
             if (m.tape().size() > tapeSizeBound)
                 break;
         }
+        out.steps += m.steps() - steps;
         if (m.tape().size() <= tapeSizeBound)
         {
-            ++enumData["counters"].count;
-            enumData["counters"].fout << setw(8) << total << '\t' << lexicalNormalForm(m.rule()).str() << '\t'
-                                      << m.tape().size() << '\n';
+            out.add("counters", lexicalNormalForm(m.rule()), m.tape().size());
             return true;
         }
     }
     return false;
 }
 
-void run(int nStates, int nSymbols, size_t maxSteps, size_t simulationSteps)
+/// Prints the statistics of the decider stages, in the given order.
+void printStageStats(const vector<decider_stage> &stages, const vector<stage_stats> &stats, span<const size_t> order)
+{
+    cout << "Decider stages:\n";
+    cout << "  " << left << setw(10) << "stage" << right << setw(12) << "calls" << setw(12) << "hits" << setw(10)
+         << "hit rate" << setw(14) << "mean cost" << setw(12) << "total" << '\n';
+    for (auto i : order)
+    {
+        const auto &st = stats[i];
+        cout << "  " << left << setw(10) << stages[i].name << right << setw(12) << st.calls << setw(12) << st.hits
+             << setw(9) << fixed << setprecision(1) << (st.calls == 0 ? 0.0 : 100.0 * st.hits / st.calls) << '%'
+             << setw(11) << setprecision(2) << (st.calls == 0 ? 0.0 : st.nanoseconds / 1000.0 / st.calls) << " us"
+             << setw(11) << setprecision(2) << st.nanoseconds / 1e9 << " s\n";
+    }
+    cout.unsetf(ios::floatfield);
+    cout << setprecision(6);
+}
+
+/// Reads stage statistics saved by `saveProfile`, as lines of `name<TAB>calls<TAB>hits<TAB>nanoseconds`. Stages that
+/// are not in the file keep their statistics, and a missing file is ignored.
+void loadProfile(const filesystem::path &path, const vector<decider_stage> &stages, vector<stage_stats> &stats)
+{
+    ifstream fin(path);
+    for (string line; getline(fin, line);)
+    {
+        istringstream ss(line);
+        string name;
+        stage_stats st;
+        if (!getline(ss, name, '\t') || !(ss >> st.calls >> st.hits >> st.nanoseconds))
+            continue;
+        const auto it = ranges::find(stages, name, &decider_stage::name);
+        if (it != stages.end())
+            stats[it - stages.begin()] = st;
+    }
+}
+
+void saveProfile(const filesystem::path &path, const vector<decider_stage> &stages, const vector<stage_stats> &stats)
+{
+    ofstream fout(path);
+    for (size_t i = 0; i < stages.size(); ++i)
+        fout << stages[i].name << '\t' << stats[i].calls << '\t' << stats[i].hits << '\t' << stats[i].nanoseconds
+             << '\n';
+}
+
+/// Number of pieces per thread that the Brady tree is split into, so that work stealing can balance uneven subtrees.
+constexpr size_t piecesPerThread = 64;
+/// Minimum number of pieces, so that checkpoints, which are only taken between pieces, are frequent.
+constexpr size_t minPieces = 4096;
+/// Number of pieces per shard that the Brady tree is split into before it is divided between the shards.
+constexpr size_t piecesPerShard = 64;
+
+/// The pieces of the Brady tree that shard `index` of `count` enumerates. They are a contiguous range of a split of the
+/// tree that only depends on the number of shards, so the shards partition the tree, and concatenating their results
+/// in order gives the result of a single run.
+inline vector<enum_node> enumShard(int nStates, int nSymbols, size_t maxSteps, size_t index, size_t count)
+{
+    auto pieces = enumSplit(nStates, nSymbols, maxSteps, max(minPieces, piecesPerShard * count));
+    const auto begin = pieces.begin() + (ptrdiff_t)(pieces.size() * index / count);
+    const auto end = pieces.begin() + (ptrdiff_t)(pieces.size() * (index + 1) / count);
+    return {make_move_iterator(begin), make_move_iterator(end)};
+}
+
+inline string outputDirectory(int nStates, int nSymbols)
+{
+    return "out/" + to_string(nStates) + "x" + to_string(nSymbols) + "/";
+}
+
+inline string shardDirectory(int nStates, int nSymbols, size_t index, size_t count)
+{
+    return outputDirectory(nStates, nSymbols) + "shard-" + to_string(index + 1) + "-of-" + to_string(count) + "/";
+}
+
+void printCounts(size_t total, boost::unordered_flat_map<string, size_t> &counts)
+{
+    cout << total << " total";
+    for (auto &&name : names)
+        if (counts[name] > 0)
+            cout << " | " << counts[name] << ' ' << name;
+    cout << '\n';
+}
+
+/// Writes telemetry of a run, one JSON line per interval, so that its throughput can be watched live:
+///
+///     {"seconds": 20.001, "machines": 1843200, "machines_per_second": 91234.512, "rss_bytes": 52428800,
+///      "stages": [{"name": "tc 32", "calls": 912345, "hits": 801234, "seconds": 4.102, "steps": 28123456,
+///                  "running": 1, "running_seconds": 0.002}, ...],
+///      "thread_utilization": [0.991, 0.987, ...]}
+///
+/// `seconds` and `machines` are totals of the run, and the other figures are of the interval since the previous line.
+/// The statistics of a stage only count the pieces that finished in the interval, so `running` is the number of
+/// threads in the stage when the line is written, and `running_seconds` is the total time that they have been in it
+/// so far, which shows a stage that holds up a piece before the piece finishes. The utilization of a thread is the
+/// fraction of the interval that it spent enumerating and classifying pieces. Lines are written by `poll`, which the
+/// run calls from a timer thread.
+class RunTelemetry
+{
+  public:
+    RunTelemetry(TelemetrySink &sink, size_t everySeconds, const vector<decider_stage> &stages, size_t threads)
+        : _sink(sink), _every(chrono::seconds(everySeconds)), _stages(stages), _stageStats(stages.size()),
+          _threads(threads)
+    {
+    }
+
+    /// Called by a thread of the run when it starts a piece.
+    void pieceStarted()
+    {
+        if (auto *t = thread())
+            t->pieceStart = elapsed();
+    }
+
+    /// Called by a thread of the run when it starts running a stage on a machine.
+    void stageStarted(size_t stage, chrono::steady_clock::time_point start)
+    {
+        if (auto *t = thread())
+        {
+            t->stageStart = chrono::duration_cast<chrono::nanoseconds>(start - _start).count();
+            t->stage = (int)stage;
+        }
+    }
+
+    /// Called by a thread of the run when it finishes running a stage on a machine.
+    void stageDone()
+    {
+        if (auto *t = thread())
+            t->stage = -1;
+    }
+
+    /// Called by a thread of the run when it finishes a piece, under the same lock as `poll`.
+    void pieceDone(const enumerate_shard &shard)
+    {
+        if (auto *t = thread())
+            t->busy += elapsed() - t->pieceStart.exchange(-1);
+        _machines += shard.total;
+        for (size_t i = 0; i < _stages.size(); ++i)
+            _stageStats[i] += shard.stages[i];
+    }
+
+    /// Writes a line if an interval has passed since the previous one, or if `force` is set.
+    void poll(bool force = false)
+    {
+        const auto now = chrono::steady_clock::now();
+        if (!force && now < _last + _every)
+            return;
+        const int64_t nanoseconds = elapsed();
+        const double interval = max(chrono::duration<double>(now - _last).count(), 1e-9);
+        ostringstream line;
+        line << fixed << setprecision(3) << "{\"seconds\":" << nanoseconds / 1e9 << ",\"machines\":" << _machines
+             << ",\"machines_per_second\":" << (double)(_machines - _lastMachines) / interval
+             << ",\"rss_bytes\":" << residentSetSize() << ",\"stages\":[";
+        vector<size_t> running(_stages.size());
+        vector<int64_t> runningNanoseconds(_stages.size());
+        for (auto &t : _threads)
+        {
+            // The stage may change while it is read, in which case the thread has just moved on
+            const int stage = t.stage;
+            const int64_t stageStart = t.stageStart;
+            if (stage >= 0 && stage == t.stage)
+            {
+                ++running[stage];
+                runningNanoseconds[stage] += max(nanoseconds - stageStart, (int64_t)0);
+            }
+        }
+        for (size_t i = 0; i < _stages.size(); ++i)
+        {
+            const auto &st = _stageStats[i];
+            const auto &prev = _lastStageStats[i];
+            line << (i > 0 ? "," : "") << "{\"name\":" << jsonString(_stages[i].name)
+                 << ",\"calls\":" << st.calls - prev.calls << ",\"hits\":" << st.hits - prev.hits
+                 << ",\"seconds\":" << (double)(st.nanoseconds - prev.nanoseconds) / 1e9
+                 << ",\"steps\":" << st.steps - prev.steps << ",\"running\":" << running[i]
+                 << ",\"running_seconds\":" << (double)runningNanoseconds[i] / 1e9 << '}';
+        }
+        line << "],\"thread_utilization\":[";
+        for (size_t i = 0; i < _threads.size(); ++i)
+        {
+            auto &t = _threads[i];
+            const auto pieceStart = t.pieceStart.load();
+            const int64_t busy = t.busy + (pieceStart >= 0 ? nanoseconds - pieceStart : 0);
+            line << (i > 0 ? "," : "") << (double)(busy - t.lastBusy) / 1e9 / interval;
+            t.lastBusy = busy;
+        }
+        line << "]}";
+        _sink.write(line.str());
+        _last = now;
+        _lastMachines = _machines;
+        _lastStageStats = _stageStats;
+    }
+
+  private:
+    /// The busy time of a thread, in nanoseconds since the start of the run.
+    struct thread_time
+    {
+        /// When the current piece started, or -1 if the thread is idle.
+        atomic<int64_t> pieceStart = -1;
+        /// The stage that the thread is running, or -1 if it is between stages, and when it started it.
+        atomic<int> stage = -1;
+        atomic<int64_t> stageStart = 0;
+        /// Total time spent on finished pieces.
+        int64_t busy = 0;
+        /// The busy time at the previous line.
+        int64_t lastBusy = 0;
+    };
+
+    [[nodiscard]] int64_t elapsed() const
+    {
+        return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - _start).count();
+    }
+
+    /// The calling thread, or null if it is not a thread of the run.
+    thread_time *thread()
+    {
+        const auto index = (size_t)tbb::this_task_arena::current_thread_index();
+        return index < _threads.size() ? &_threads[index] : nullptr;
+    }
+
+    TelemetrySink &_sink;
+    chrono::steady_clock::duration _every;
+    const vector<decider_stage> &_stages;
+    chrono::steady_clock::time_point _start = chrono::steady_clock::now();
+    chrono::steady_clock::time_point _last = _start;
+    size_t _machines = 0;
+    size_t _lastMachines = 0;
+    vector<stage_stats> _stageStats;
+    vector<stage_stats> _lastStageStats = _stageStats;
+    vector<thread_time> _threads;
+};
+
+/// Enumerates shard `shard.first` of `shard.second`. Unless there is only one shard, its results are written to its
+/// own directory, along with a file of its counts, to be combined by `mergeShards`.
+void run(int nStates, int nSymbols, size_t maxSteps, size_t simulationSteps, size_t threads, size_t checkpointEvery,
+         optional<enumerate_checkpoint> resumed, pair<size_t, size_t> shard, bool binary, bool adaptive,
+         const string &profilePath, TelemetrySink *telemetrySink, size_t telemetryEvery)
 {
     auto &&[cyclerPBound, cyclerSBound] = getCyclerBounds(nStates, nSymbols);
     auto &&[tcPBound, tcSBound] = getTCBounds(nStates, nSymbols);
     size_t tcCutoff = interestingTCCutoff(nStates, nSymbols);
-    string directory = "out/";
-    directory += to_string(nStates) + "x" + to_string(nSymbols) + "/";
-    for (auto &&name : names)
-        enumData[name].fout.open(directory + name + ".txt");
-    enumData["unclassified"].fout << fixed << setprecision(6);
+    const auto [shardIndex, shardCount] = shard;
+    string directory = outputDirectory(nStates, nSymbols);
+    if (shardCount > 1)
+    {
+        directory = shardDirectory(nStates, nSymbols, shardIndex, shardCount);
+        error_code ec;
+        filesystem::create_directories(directory, ec);
+    }
+    const filesystem::path checkpointPath = directory + "checkpoint";
+    // When resuming, the machines written after the checkpoint are dropped.
+    enumerate_output output(directory, binary, resumed ? &resumed->fileSizes : nullptr);
 
-    auto printCounts = [&]() {
-        cout << total << " total";
-        for (auto &&name : names)
-            if (enumData[name].count > 0)
-                cout << " | " << enumData[name].count << ' ' << name;
-        cout << '\n';
+    // Totals of the committed shards
+    size_t total = resumed ? resumed->total : 0;
+    boost::unordered_flat_map<string, size_t> counts;
+    if (resumed)
+        counts = resumed->counts;
+    // The decider pipeline. Unless the order is fixed, the stages are reordered as statistics come in.
+    const vector<decider_stage> stages{
+        {"tc 32", {}, [&](auto &c, auto &out) { return tcFast(c.m, out, 32, 16); }},
+        {"cycler", {}, [&](auto &c, auto &out) { return cyclerFast(c.m, out, cyclerSBound, cyclerPBound); }},
+        // Translated cyclers found in 32 steps are only written out if the cutoff is that low
+        {"tc 2048", tcCutoff > 32 ? vector<size_t>{} : vector<size_t>{0},
+         [&](auto &c, auto &out) { return tc(c.m, out, 2048, 1024, tcCutoff); }},
+        // The bouncer decider would also claim some cyclers with long preperiods
+        {"bouncer", {0, 1, 2}, [&](auto &c, auto &out) {
+             return bouncer(c, out, 4, 25000, 3000, 6, [&](auto res) {
+                 if (res.degree == 2)
+                     return nStates <= 3 || res.xPeriod >= 10 || res.start >= 1000;
+                 if (res.degree == 3)
+                     return nStates <= 4 || res.xPeriod >= 10 || res.start >= 1000;
+                 return true;
+             });
+         }},
+        // Finite automata reduction would also claim the cyclers, translated cyclers and bouncers that have an
+        // undefined transition, so it comes after their deciders, and spares its machines the long simulations of the
+        // last two
+        {"far", {0, 1, 2, 3}, [&](auto &c, auto &out) { return far(c.m, out, 5, 100000); }},
+        // Cyclers have bounded tapes, so they must be claimed before the counter decider
+        {"counter", {1, 3, 4}, [&](auto &c, auto &out) { return counter(c, out, simulationSteps); }},
+        {"tc", {4, 5}, [&](auto &c, auto &out) { return tc(c.m, out, tcSBound, tcPBound, tcCutoff); }}};
+    // Statistics of the committed shards, and of the profile of an earlier run
+    vector<stage_stats> stageStats(stages.size());
+    vector<stage_stats> priorStats(stages.size());
+    if (!profilePath.empty())
+        loadProfile(profilePath, stages, priorStats);
+    const auto orderStats = [&]() {
+        auto res = priorStats;
+        for (size_t i = 0; i < res.size(); ++i)
+            res[i] += stageStats[i];
+        return res;
+    };
+    vector<size_t> order(stages.size());
+    iota(order.begin(), order.end(), 0);
+    const auto printOrder = [&]() {
+        cout << ansi::dim << "  Decider order:";
+        for (auto i : order)
+            cout << ' ' << stages[i].name;
+        cout << ansi::reset << '\n';
+    };
+    if (adaptive)
+    {
+        order = pipelineOrder(stages, orderStats());
+        printOrder();
+    }
+
+    optional<RunTelemetry> telemetry;
+    if (telemetrySink != nullptr)
+        telemetry.emplace(*telemetrySink, telemetryEvery, stages, threads);
+
+    auto classify = [&](const turing_rule &rule, Arena &arena, enumerate_shard &out, span<const size_t> pieceOrder) {
+        ++out.total;
+        // The machine and the deciders' copies of it are freed at once when it is classified
+        const ArenaScope scope{arena};
+        candidate c{.m = ArenaTuringMachine{rule}, .bouncer = {}};
+        for (auto i : pieceOrder)
+        {
+            const auto start = chrono::steady_clock::now();
+            const auto steps = out.steps;
+            if (telemetry)
+                telemetry->stageStarted(i, start);
+            const bool hit = stages[i].decide(c, out);
+            if (telemetry)
+                telemetry->stageDone();
+            auto &stats = out.stages[i];
+            ++stats.calls;
+            stats.hits += hit;
+            stats.nanoseconds +=
+                chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - start).count();
+            stats.steps += out.steps - steps;
+            if (hit)
+                return;
+        }
+
+        out.add("unclassified", lexicalNormalForm(c.m.rule()));
     };
 
-    enumTMs(nStates, nSymbols, maxSteps, [&](auto m) {
-        m.reset();
-        ++total;
-        if (total % 10'000 == 0)
+    // Enumerates and classifies the machines of one piece of the tree.
+    mutex commitMutex;
+    auto classifyPiece = [&](enum_node root) {
+        enumerate_shard out;
+        out.stages.resize(stages.size());
+        const auto pieceOrder = [&]() {
+            const lock_guard lock{commitMutex};
+            return order;
+        }();
+        // The tapes of the tree nodes and of the deciders' machines
+        Arena arena;
+        enumTMs(root, arena, nStates, nSymbols, maxSteps,
+                [&](const auto &m) { classify(m.rule(), arena, out, pieceOrder); });
+        return out;
+    };
+
+    // Writes out a shard, numbering its machines after the ones already written.
+    auto commit = [&](const enumerate_shard &shard) {
+        for (auto r : shard.records)
+        {
+            r.index += total;
+            output.write(r);
+        }
+        for (auto &&[name, count] : shard.counts)
+            counts[name] += count;
+        for (size_t i = 0; i < stages.size(); ++i)
+            stageStats[i] += shard.stages[i];
+        if (adaptive)
+            if (auto newOrder = pipelineOrder(stages, orderStats()); newOrder != order)
+            {
+                order = std::move(newOrder);
+                printOrder();
+            }
+        const size_t before = total;
+        total += shard.total;
+        if (total / 10'000 != before / 10'000)
         {
             cout << ansi::dim << "  (so far) ";
-            printCounts();
+            printCounts(total, counts);
             cout << ansi::reset;
         }
-        if (tcFast(m, 32, 16))
-            return;
-        if (cyclerFast(m, cyclerSBound, cyclerPBound))
-            return;
-        if (tc(m, 2048, 1024, tcCutoff))
-            return;
-        if (bouncer(m, 4, 25000, 3000, 6, [&](auto res) {
-                if (res.degree == 2)
-                    return nStates <= 3 || res.xPeriod >= 10 || res.start >= 1000;
-                if (res.degree == 3)
-                    return nStates <= 4 || res.xPeriod >= 10 || res.start >= 1000;
-                return true;
-            }))
-            return;
-        if (counter(m, simulationSteps))
-            return;
-        if (tc(m, tcSBound, tcPBound, tcCutoff))
-            return;
+    };
 
-        ++enumData["unclassified"].count;
-        enumData["unclassified"].fout << setw(8) << total << '\t' << lexicalNormalForm(m.rule()).str() << '\n';
+    // Pieces are classified by a work-stealing scheduler in any order, and committed in enumeration order as soon as
+    // all earlier pieces are done.
+    const size_t numPieces = max(piecesPerThread * threads, minPieces);
+    const auto pieces =
+        enumSplit(resumed ? std::move(resumed->pieces) : enumShard(nStates, nSymbols, maxSteps, shardIndex, shardCount),
+                  nStates, nSymbols, maxSteps, numPieces);
+    vector<optional<enumerate_shard>> done(pieces.size());
+    size_t nextCommit = 0;
+
+    auto nextCheckpoint = chrono::steady_clock::now() + chrono::seconds(checkpointEvery);
+    auto checkpoint = [&]() {
+        enumerate_checkpoint c;
+        c.nStates = nStates;
+        c.nSymbols = nSymbols;
+        c.maxSteps = maxSteps;
+        c.simulationSteps = simulationSteps;
+        c.binary = binary;
+        c.total = total;
+        c.counts = counts;
+        c.fileSizes = output.sizes();
+        c.pieces.assign(pieces.begin() + (ptrdiff_t)nextCommit, pieces.end());
+        try
+        {
+            saveCheckpoint(c, checkpointPath);
+        }
+        catch (const exception &e)
+        {
+            cerr << ansi::red << e.what() << ", not saving any more checkpoints" << ansi::reset << '\n';
+            checkpointEvery = 0;
+        }
+    };
+    // Writes telemetry lines on time even while every thread is busy with a long piece
+    jthread telemetryTimer;
+    if (telemetry)
+        telemetryTimer = jthread([&](stop_token stop) {
+            condition_variable_any wake;
+            unique_lock lock{commitMutex};
+            while (!wake.wait_for(lock, stop, chrono::seconds(1), [&] { return stop.stop_requested(); }))
+                telemetry->poll();
+        });
+    tbb::task_arena arena((int)threads);
+    arena.execute([&] {
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, pieces.size(), 1), [&](const tbb::blocked_range<size_t> &r) {
+            for (size_t i = r.begin(); i < r.end(); ++i)
+            {
+                if (telemetry)
+                    telemetry->pieceStarted();
+                auto shard = classifyPiece(pieces[i]);
+                const lock_guard lock{commitMutex};
+                if (telemetry)
+                    telemetry->pieceDone(shard);
+                done[i] = std::move(shard);
+                for (; nextCommit < done.size() && done[nextCommit]; ++nextCommit)
+                {
+                    commit(*done[nextCommit]);
+                    done[nextCommit].reset();
+                }
+                if (checkpointEvery > 0 && chrono::steady_clock::now() >= nextCheckpoint)
+                {
+                    checkpoint();
+                    nextCheckpoint = chrono::steady_clock::now() + chrono::seconds(checkpointEvery);
+                }
+            }
+        });
     });
+    if (telemetry)
+    {
+        telemetryTimer.request_stop();
+        telemetryTimer.join();
+        telemetry->poll(true);
+    }
+    error_code ec;
+    filesystem::remove(checkpointPath, ec);
+    if (shardCount > 1)
+    {
+        ofstream fout(directory + "counts.txt");
+        fout << "total\t" << total << '\n';
+        for (auto &&name : names)
+            fout << name << '\t' << counts[name] << '\n';
+    }
     cout << "Final count: ";
-    printCounts();
+    printCounts(total, counts);
+    printStageStats(stages, stageStats, order);
+    if (!profilePath.empty())
+        saveProfile(profilePath, stages, stageStats);
+}
+
+/// Combines the results of `count` finished shards into out/{n}x{k}, renumbering the machines of each shard after the
+/// ones of the shards before it. Throws `std::runtime_error` if a shard has not finished.
+void mergeShards(int nStates, int nSymbols, size_t count, bool binary)
+{
+    enumerate_output output(outputDirectory(nStates, nSymbols), binary);
+
+    size_t total = 0;
+    boost::unordered_flat_map<string, size_t> counts;
+    for (size_t i = 0; i < count; ++i)
+    {
+        const auto shardDir = shardDirectory(nStates, nSymbols, i, count);
+        ifstream countsFile(shardDir + "counts.txt");
+        if (!countsFile)
+            throw runtime_error("Shard " + to_string(i + 1) + "/" + to_string(count) + " has not finished");
+        size_t shardTotal = 0;
+        for (string line; getline(countsFile, line);)
+        {
+            const auto tab = line.find('\t');
+            const auto name = line.substr(0, tab);
+            const size_t n = stoull(line.substr(tab + 1));
+            if (name == "total")
+                shardTotal = n;
+            else
+                counts[name] += n;
+        }
+        if (binary)
+            for (auto r : seeds::Database{shardDir + "seeds.bin"})
+            {
+                r.index += total;
+                output.write(r);
+            }
+        else
+            for (auto &&name : names)
+            {
+                ifstream fin(shardDir + name + ".txt");
+                for (string line; getline(fin, line);)
+                {
+                    auto r = seeds::seed_record::parse(seeds::category(name), line);
+                    r.index += total;
+                    output.write(r);
+                }
+            }
+        total += shardTotal;
+    }
+    cout << "Final count: ";
+    printCounts(total, counts);
 }
 
 int main(int argc, char *argv[])
@@ -329,17 +1133,49 @@ Options:
                    BB(n, k) when it is known)
   -s, --sim-steps  The number of steps to simulate enumerated machines for, for
                    purposes of classification (default: 1000000)
+  -j, --threads    The number of threads to use (default: all)
+  --checkpoint-every <seconds>
+                   How often to save the progress to out/{n}x{k}/checkpoint,
+                   or 0 to never save it (default: 60)
+  --resume         Continue from the checkpoint of an interrupted run with the
+                   same arguments
+  --shard <i>/<N>  Only enumerate the i-th of N parts of the machines, for
+                   1 <= i <= N, into out/{n}x{k}/shard-{i}-of-{N}
+  --merge <N>      Combine the results of N finished shards into out/{n}x{k}
+  --binary         Write the machines to a binary seed database seeds.bin
+                   instead of a text file for each category
+  --fixed-order    Don't reorder the deciders by their measured hit rates and
+                   costs
+  --profile <file> Start with the decider statistics in the file, if it
+                   exists, and save the statistics of this run to it
+  --telemetry <dest>
+                   Write throughput statistics as JSON lines to a file, or to
+                   the Unix domain socket at <path> if <dest> is unix:<path>:
+                   machines per second, time and steps per decider stage,
+                   memory use and the utilization of each thread
+  --telemetry-every <seconds>
+                   How often to write telemetry (default: 10)
 
 Comments:
   This tool outputs to a file in the directory out/{n}x{k}. Please create this
   directory if it does not exist before running this tool, otherwise no file
-  will be written.
+  will be written. The checkpoint is deleted when the run finishes.
 )";
     const span args(argv, argc);
     int nStates = 3;
     int nSymbols = 2;
     size_t maxSteps = std::numeric_limits<size_t>::max();
     size_t simSteps = 100000;
+    size_t threads = tbb::info::default_concurrency();
+    size_t checkpointEvery = 60;
+    bool resume = false;
+    pair<size_t, size_t> shard{0, 1};
+    size_t merge = 0;
+    bool binary = false;
+    bool adaptive = true;
+    string profilePath;
+    string telemetryPath;
+    size_t telemetryEvery = 10;
     int argPos = 0;
     for (int i = 1; i < argc; ++i)
     {
@@ -352,6 +1188,36 @@ Comments:
             maxSteps = parseNumber(args[++i]);
         else if (strcmp(args[i], "-s") == 0 || strcmp(args[i], "--sim-steps") == 0)
             simSteps = parseNumber(args[++i]);
+        else if (strcmp(args[i], "-j") == 0 || strcmp(args[i], "--threads") == 0)
+            threads = max(parseNumber(args[++i]), 1UZ);
+        else if (strcmp(args[i], "--checkpoint-every") == 0)
+            checkpointEvery = parseNumber(args[++i]);
+        else if (strcmp(args[i], "--resume") == 0)
+            resume = true;
+        else if (strcmp(args[i], "--shard") == 0)
+        {
+            const string arg = args[++i];
+            const auto slash = arg.find('/');
+            if (slash != string::npos)
+                shard = {parseNumber(arg.substr(0, slash)) - 1, parseNumber(arg.substr(slash + 1))};
+            if (slash == string::npos || shard.first >= shard.second)
+            {
+                cerr << ansi::red << "Invalid shard: " << ansi::reset << arg << '\n';
+                return 1;
+            }
+        }
+        else if (strcmp(args[i], "--merge") == 0)
+            merge = parseNumber(args[++i]);
+        else if (strcmp(args[i], "--binary") == 0)
+            binary = true;
+        else if (strcmp(args[i], "--fixed-order") == 0)
+            adaptive = false;
+        else if (strcmp(args[i], "--profile") == 0)
+            profilePath = args[++i];
+        else if (strcmp(args[i], "--telemetry") == 0)
+            telemetryPath = args[++i];
+        else if (strcmp(args[i], "--telemetry-every") == 0)
+            telemetryEvery = parseNumber(args[++i]);
         else if (argPos == 0)
         {
             ++argPos;
@@ -372,6 +1238,56 @@ Comments:
     nSymbols = std::min(nSymbols, 4);
     if (maxSteps == std::numeric_limits<size_t>::max())
         maxSteps = defaultMaxSteps(nStates, nSymbols);
+    if (merge > 0)
+    {
+        try
+        {
+            printTiming(mergeShards, nStates, nSymbols, merge, binary);
+        }
+        catch (const exception &e)
+        {
+            cerr << ansi::red << e.what() << ansi::reset << '\n';
+            return 1;
+        }
+        return 0;
+    }
+    optional<enumerate_checkpoint> resumed;
+    if (resume)
+    {
+        const auto path = (shard.second > 1 ? shardDirectory(nStates, nSymbols, shard.first, shard.second)
+                                             : outputDirectory(nStates, nSymbols)) +
+                          "checkpoint";
+        try
+        {
+            resumed = loadCheckpoint(path);
+        }
+        catch (const exception &e)
+        {
+            cerr << ansi::red << e.what() << ansi::reset << '\n';
+            return 1;
+        }
+        if (resumed->nStates != nStates || resumed->nSymbols != nSymbols || resumed->maxSteps != maxSteps ||
+            resumed->simulationSteps != simSteps || resumed->binary != binary)
+        {
+            cerr << ansi::red << "The checkpoint was saved with different arguments" << ansi::reset << '\n';
+            return 1;
+        }
+        cout << "Resuming after " << resumed->total << " machines\n";
+    }
+    optional<TelemetrySink> telemetry;
+    if (!telemetryPath.empty())
+    {
+        try
+        {
+            telemetry.emplace(telemetryPath);
+        }
+        catch (const exception &e)
+        {
+            cerr << ansi::red << e.what() << ansi::reset << '\n';
+            return 1;
+        }
+    }
     cout << "(# states, # symbols, max steps) = " << tuple{nStates, nSymbols, maxSteps} << '\n';
-    printTiming(run, nStates, nSymbols, maxSteps, simSteps);
+    printTiming(run, nStates, nSymbols, maxSteps, simSteps, threads, checkpointEvery, std::move(resumed), shard, binary,
+                adaptive, profilePath, telemetry ? &*telemetry : nullptr, telemetryEvery);
 }
@@ -0,0 +1,122 @@
+#pragma once
+
+#include "mapped_file.hpp"
+#include "seeds.hpp"
+#include "turing.hpp"
+
+namespace turing
+{
+/// A memory-mapped database of machines with random access to machine #i and no text parsing. Reads the bbchallenge
+/// format, which is a 30-byte header followed by one record of 3 bytes per transition for each machine, and the seed
+/// databases written by `enumerate --binary`, which are recognized by their header.
+///
+/// In a bbchallenge record, a transition is (symbol to write, 0 for a right move or 1 for a left move, next state
+/// with 1 for A, or 0 if undefined). The standard database has 5-state 2-symbol machines with 30-byte records.
+class MachineDatabase
+{
+  public:
+    static constexpr size_t bbchallengeHeaderSize = 30;
+
+    /// Opens a database. `nStates` and `nSymbols` are the size of the machines of a bbchallenge database, and are
+    /// ignored for a seed database. Throws `std::runtime_error` if the file can't be read or has the wrong size.
+    explicit MachineDatabase(const std::filesystem::path &path, size_t nStates = 5, size_t nSymbols = 2)
+        : _file(path), _nStates(nStates), _nSymbols(nSymbols)
+    {
+        const auto isSeeds = _file.size() >= seeds::magic.size() &&
+                             std::memcmp(_file.data(), seeds::magic.data(), seeds::magic.size()) == 0;
+        if (isSeeds)
+        {
+            _seeds.emplace(std::move(_file), path);
+            _size = _seeds->size();
+            return;
+        }
+        if (nStates * nSymbols == 0 || nStates > maxStates || nSymbols > maxSymbols)
+            throw std::runtime_error("Invalid machine size for " + path.string());
+        _recordSize = 3 * nStates * nSymbols;
+        if (_file.size() < bbchallengeHeaderSize || (_file.size() - bbchallengeHeaderSize) % _recordSize != 0)
+            throw std::runtime_error("Not a database of " + std::to_string(nStates) + "-state " +
+                                     std::to_string(nSymbols) + "-symbol machines: " + path.string());
+        _size = (_file.size() - bbchallengeHeaderSize) / _recordSize;
+    }
+
+    [[nodiscard]] size_t size() const { return _size; }
+
+    /// The rule of machine #i. Undefined transitions, which stand for halting ones in bbchallenge databases, are
+    /// "---".
+    [[nodiscard]] turing_rule operator[](size_t i) const
+    {
+        assert(i < _size);
+        if (_seeds)
+            return (*_seeds)[i].rule();
+        turing_rule rule(_nStates, _nSymbols);
+        const auto *p = (const uint8_t *)_file.data() + bbchallengeHeaderSize + i * _recordSize;
+        for (size_t s = 0; s < _nStates; ++s)
+            for (size_t j = 0; j < _nSymbols; ++j, p += 3)
+                if (p[2] == 0)
+                    rule[s, j] = {.symbol = 1, .direction = direction::right, .toState = -1};
+                else
+                    rule[s, j] = {.symbol = p[0],
+                                  .direction = p[1] == 0 ? direction::right : direction::left,
+                                  .toState = (state_type)(p[2] - 1)};
+        return rule;
+    }
+
+    /// The ID of machine #i: its position in a bbchallenge database, or its enumeration index in a seed database.
+    [[nodiscard]] uint64_t id(size_t i) const { return _seeds ? (*_seeds)[i].index : i; }
+
+    /// Tells the OS that the database will be read in order.
+    void adviseSequential() const { _file.adviseSequential(); }
+
+  private:
+    MappedFile _file;
+    std::optional<seeds::Database> _seeds;
+    size_t _nStates;
+    size_t _nSymbols;
+    size_t _recordSize = 0;
+    size_t _size = 0;
+};
+
+/// A memory-mapped index file of a machine database, such as the list of undecided machines: the positions of machines
+/// in the database, as big-endian 32-bit integers.
+class MachineIndex
+{
+  public:
+    /// Throws `std::runtime_error` if the file can't be read or its size is not a multiple of 4.
+    explicit MachineIndex(const std::filesystem::path &path) : _file(path)
+    {
+        if (_file.size() % sizeof(uint32_t) != 0)
+            throw std::runtime_error("Not an index file: " + path.string());
+    }
+
+    [[nodiscard]] size_t size() const { return _file.size() / sizeof(uint32_t); }
+
+    [[nodiscard]] uint32_t operator[](size_t i) const
+    {
+        assert(i < size());
+        uint32_t x = 0;
+        std::memcpy(&x, _file.data() + i * sizeof(uint32_t), sizeof(uint32_t));
+        return std::endian::native == std::endian::little ? std::byteswap(x) : x;
+    }
+
+  private:
+    MappedFile _file;
+};
+
+/// Calls `f(id, rule)` on entries [begin, end) of the index if there is one, or on machines [begin, end) of the
+/// database otherwise. The range is clamped to the size of the index or the database. Throws `std::runtime_error` if
+/// the index refers to a machine that is not in the database.
+template <typename Callback>
+void forEachMachine(const MachineDatabase &db, const MachineIndex *index, size_t begin, size_t end, Callback f)
+{
+    end = std::min(end, index != nullptr ? index->size() : db.size());
+    if (index == nullptr)
+        db.adviseSequential();
+    for (size_t i = begin; i < end; ++i)
+    {
+        const size_t pos = index != nullptr ? (*index)[i] : i;
+        if (pos >= db.size())
+            throw std::runtime_error("Machine " + std::to_string(pos) + " is not in the database");
+        f(db.id(pos), db[pos]);
+    }
+}
+} // namespace turing
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#if __has_include(<sys/mman.h>)
+#define TURING_MAPPED_FILE
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace turing
+{
+/// A read-only view of a whole file. The file is mapped into memory with `mmap` where it is available, so only the
+/// pages that are accessed are read, and read into memory otherwise. The data is aligned to at least 8 bytes.
+class MappedFile
+{
+  public:
+    MappedFile() = default;
+
+    /// Throws `std::runtime_error` if the file can't be opened or mapped.
+    explicit MappedFile(const std::filesystem::path &path)
+    {
+#ifdef TURING_MAPPED_FILE
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0)
+            throw std::runtime_error("Failed to open " + path.string());
+        struct stat st
+        {
+        };
+        if (fstat(fd, &st) != 0)
+        {
+            ::close(fd);
+            throw std::runtime_error("Failed to open " + path.string());
+        }
+        _size = (size_t)st.st_size;
+        if (_size > 0)
+        {
+            void *p = mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED)
+            {
+                ::close(fd);
+                throw std::runtime_error("Failed to map " + path.string());
+            }
+            _mapped = (const std::byte *)p;
+        }
+        ::close(fd);
+#else
+        std::ifstream fin(path, std::ios::binary | std::ios::ate);
+        if (!fin)
+            throw std::runtime_error("Failed to open " + path.string());
+        _size = (size_t)fin.tellg();
+        _buffer.resize((_size + sizeof(uint64_t) - 1) / sizeof(uint64_t));
+        fin.seekg(0);
+        if (!fin.read((char *)_buffer.data(), (std::streamsize)_size))
+            throw std::runtime_error("Failed to read " + path.string());
+#endif
+    }
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept
+        : _mapped(std::exchange(other._mapped, nullptr)), _buffer(std::move(other._buffer)),
+          _size(std::exchange(other._size, 0))
+    {
+    }
+
+    MappedFile &operator=(MappedFile other) noexcept
+    {
+        std::swap(_mapped, other._mapped);
+        std::swap(_buffer, other._buffer);
+        std::swap(_size, other._size);
+        return *this;
+    }
+
+    ~MappedFile()
+    {
+#ifdef TURING_MAPPED_FILE
+        if (_mapped != nullptr)
+            munmap((void *)_mapped, _size);
+#endif
+    }
+
+    [[nodiscard]] const std::byte *data() const
+    {
+        return _mapped != nullptr ? _mapped : (const std::byte *)_buffer.data();
+    }
+    [[nodiscard]] size_t size() const { return _size; }
+    [[nodiscard]] std::span<const std::byte> bytes() const { return {data(), _size}; }
+
+    /// Tells the OS that the file will be read from start to end, so it can read ahead aggressively.
+    void adviseSequential() const
+    {
+#if defined(TURING_MAPPED_FILE) && defined(MADV_SEQUENTIAL)
+        if (_mapped != nullptr)
+            madvise((void *)_mapped, _size, MADV_SEQUENTIAL);
+#endif
+    }
+
+  private:
+    const std::byte *_mapped = nullptr;
+    /// The contents of the file if it isn't mapped.
+    std::vector<uint64_t> _buffer;
+    size_t _size = 0;
+};
+} // namespace turing
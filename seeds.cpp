@@ -0,0 +1,98 @@
+// Utility to convert the output of enumerate between text files and a binary seed database.
+
+#include "pch.hpp"
+#include "seeds.hpp"
+
+using namespace std;
+using namespace turing;
+
+/// Writes the records of directory/seeds.bin to a text file for each category in the directory.
+void toText(const filesystem::path &directory)
+{
+    const seeds::Database db{directory / "seeds.bin"};
+    array<ofstream, seeds::categories.size()> files;
+    for (size_t i = 0; i < files.size(); ++i)
+        files[i].open(directory / (string(seeds::categories[i]) + ".txt"));
+    for (auto &&r : db)
+        files.at(r.category) << r.str() << '\n';
+    cout << db.size() << " machines\n";
+}
+
+/// Writes the machines of the category text files in the directory to directory/seeds.bin, in order of their index.
+void fromText(const filesystem::path &directory)
+{
+    vector<seeds::seed_record> records;
+    for (size_t i = 0; i < seeds::categories.size(); ++i)
+    {
+        ifstream fin(directory / (string(seeds::categories[i]) + ".txt"));
+        for (string line; getline(fin, line);)
+            records.push_back(seeds::seed_record::parse((uint8_t)i, line));
+    }
+    ranges::stable_sort(records, {}, &seeds::seed_record::index);
+    ofstream fout(directory / "seeds.bin", ios::binary | ios::trunc);
+    seeds::writeHeader(fout);
+    for (auto &&r : records)
+        seeds::write(fout, r);
+    if (!fout)
+        throw runtime_error("Failed to write " + (directory / "seeds.bin").string());
+    cout << records.size() << " machines\n";
+}
+
+int main(int argc, char *argv[])
+{
+    constexpr string_view help = R"(Seed database conversion tool
+
+Usage: ./run seeds <command> <dir>
+
+Arguments:
+  <command>  to-text:   Convert <dir>/seeds.bin to a text file for each
+                        category in <dir>
+             from-text: Convert the text files of the categories in <dir> to
+                        <dir>/seeds.bin
+  <dir>      A directory written by enumerate, like out/4x2
+
+Options:
+  -h, --help  Show this help message
+)";
+    const span args(argv, argc);
+    string command;
+    filesystem::path directory;
+    int argPos = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (strcmp(args[i], "-h") == 0 || strcmp(args[i], "--help") == 0)
+        {
+            cout << help;
+            return 0;
+        }
+        if (argPos == 0)
+        {
+            ++argPos;
+            command = args[i];
+        }
+        else if (argPos == 1)
+        {
+            ++argPos;
+            directory = args[i];
+        }
+        else
+        {
+            cerr << ansi::red << "Unexpected argument: " << ansi::reset << args[i] << '\n' << help;
+            return 0;
+        }
+    }
+    if (directory.empty() || (command != "to-text" && command != "from-text"))
+    {
+        cout << help;
+        return 0;
+    }
+    try
+    {
+        printTiming(command == "to-text" ? toText : fromText, directory);
+    }
+    catch (const runtime_error &e)
+    {
+        cerr << ansi::red << e.what() << ansi::reset << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+#include <bit>
+#include <charconv>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "mapped_file.hpp"
+#include "turing.hpp"
+
+namespace turing
+{
+/// The binary seed database written by `enumerate --binary`: the machines that `enumerate` writes out, as fixed-width
+/// records in the spirit of the bbchallenge seed database. Formatting and parsing text lines dominates tools that read
+/// millions of machines, while this format can be memory-mapped and indexed directly. It converts losslessly to and
+/// from the category text files.
+///
+/// A file is a 64-byte header followed by 64-byte `seed_record`s in order of their index, in native little-endian
+/// layout:
+///
+///     magic "TMSEEDS\0" | version u32 | record size u32 | 48 reserved bytes
+namespace seeds
+{
+constexpr std::string_view magic{"TMSEEDS\0", 8};
+constexpr uint32_t version = 1;
+constexpr size_t headerSize = 64;
+constexpr size_t maxFields = 3;
+/// 6 states with 4 symbols, the largest machines that `enumerate` enumerates.
+constexpr size_t maxTransitions = 24;
+
+/// The categories of `enumerate`, in the order of their numbers in records. New categories go at the end, so that the
+/// numbers in existing databases stay valid.
+constexpr std::array<std::string_view, 10> categories{
+    "cyclers", "tcyclers", "bouncers", "cubic bells", "quartic bells", "quintic bells", "bells", "counters",
+    "unclassified", "far"};
+
+/// Returns the number of the category, or throws `std::runtime_error` if there is no such category.
+inline uint8_t category(std::string_view name)
+{
+    const auto it = std::ranges::find(categories, name);
+    if (it == categories.end())
+        throw std::runtime_error("Unknown category " + std::string(name));
+    return (uint8_t)(it - categories.begin());
+}
+
+/// Marks a field whose value is unknown, written as "?" in text files.
+struct unknown_t
+{
+};
+constexpr unknown_t unknown;
+
+/// A machine of the seed database: its index in the enumeration, its category, its rule and the parameters that the
+/// decider found. The meaning of the fields depends on the category:
+///
+///     cyclers                        period, preperiod
+///     tcyclers                       period, preperiod, offset; or ?, start, x period if the bouncer decider found it
+///     bouncers, cubic bells          start, x period
+///     quartic bells, quintic bells   degree, start, x period
+///     counters                       tape size
+///     far                            DFA states, 1 if the DFA is of the mirrored machine and 0 otherwise
+///     bells, unclassified            none
+///
+/// In text files, a record is the line `index<TAB>code<TAB>field...`, with the index right-aligned in 8 columns.
+struct seed_record
+{
+    uint64_t index = 0;
+    uint8_t category = 0;
+    uint8_t numStates = 0;
+    uint8_t numSymbols = 0;
+    uint8_t numFields = 0;
+    /// Bit i is set if field i is unknown.
+    uint8_t unknownFields = 0;
+    std::array<uint8_t, 3> reserved{};
+    std::array<int64_t, maxFields> fields{};
+    /// The transitions in order of state, then symbol. Bits 0-2 are the symbol to write, bit 3 is set for a right
+    /// move, and bits 4-7 are the next state, `haltState` for Z, or `undefinedState` for an undefined transition.
+    std::array<uint8_t, maxTransitions> transitions{};
+
+    static constexpr uint8_t haltState = 14;
+    static constexpr uint8_t undefinedState = 15;
+
+    /// Throws `std::runtime_error` if the rule doesn't fit in a record.
+    static seed_record make(uint64_t index, uint8_t category, const turing_rule &rule)
+    {
+        if (rule.numStates() * rule.numSymbols() > maxTransitions || rule.numSymbols() > 8)
+            throw std::runtime_error("Rule too large for a seed record: " + rule.str());
+        seed_record r;
+        r.index = index;
+        r.category = category;
+        r.numStates = (uint8_t)rule.numStates();
+        r.numSymbols = (uint8_t)rule.numSymbols();
+        for (size_t i = 0; i < rule.numStates(); ++i)
+            for (size_t j = 0; j < rule.numSymbols(); ++j)
+            {
+                const auto &tr = rule[i, j];
+                uint8_t toState = haltState;
+                if (tr.toState == -1)
+                {
+                    r.transitions[i * rule.numSymbols() + j] = undefinedState << 4;
+                    continue;
+                }
+                if (tr.toState >= 0 && tr.toState < haltState)
+                    toState = (uint8_t)tr.toState;
+                else if (tr.toState != 'Z' - 'A')
+                    throw std::runtime_error("Unsupported state in a seed record: " + rule.str());
+                r.transitions[i * rule.numSymbols() + j] =
+                    tr.symbol | (uint8_t)(tr.direction == direction::right) << 3 | toState << 4;
+            }
+        return r;
+    }
+
+    [[nodiscard]] turing_rule rule() const
+    {
+        turing_rule rule(numStates, numSymbols);
+        for (size_t i = 0; i < numStates; ++i)
+            for (size_t j = 0; j < numSymbols; ++j)
+            {
+                const auto t = transitions[i * numSymbols + j];
+                const auto toState = t >> 4;
+                if (toState == undefinedState)
+                    rule[i, j] = {.symbol = 1, .direction = direction::right, .toState = -1};
+                else
+                    rule[i, j] = {.symbol = (symbol_type)(t & 7),
+                                  .direction = (t & 8) != 0 ? direction::right : direction::left,
+                                  .toState = (state_type)(toState == haltState ? 'Z' - 'A' : toState)};
+            }
+        return rule;
+    }
+
+    [[nodiscard]] std::string_view categoryName() const { return categories.at(category); }
+
+    void add(std::integral auto x)
+    {
+        assert(numFields < maxFields);
+        fields[numFields++] = (int64_t)x;
+    }
+
+    void add(unknown_t)
+    {
+        assert(numFields < maxFields);
+        unknownFields |= 1 << numFields++;
+    }
+
+    /// The line of the record in a text file, without the newline.
+    [[nodiscard]] std::string str() const
+    {
+        std::string index = std::to_string(this->index);
+        std::string s = index.size() < 8 ? std::string(8 - index.size(), ' ') + index : index;
+        s += '\t';
+        s += rule().str();
+        for (size_t i = 0; i < numFields; ++i)
+        {
+            s += '\t';
+            s += (unknownFields >> i & 1) != 0 ? "?" : std::to_string(fields[i]);
+        }
+        return s;
+    }
+
+    /// Parses a line of a text file of the category. Throws `std::runtime_error` if the line is invalid.
+    static seed_record parse(uint8_t category, std::string_view line)
+    {
+        const auto whole = line;
+        const auto next = [&]() {
+            const auto field = line.substr(0, line.find('\t'));
+            line.remove_prefix(std::min(line.size(), field.size() + 1));
+            return field;
+        };
+        const auto invalid = [&]() { return std::runtime_error("Invalid seed line: " + std::string(whole)); };
+        auto indexField = next();
+        while (!indexField.empty() && indexField.front() == ' ')
+            indexField.remove_prefix(1);
+        uint64_t index = 0;
+        const auto *indexEnd = indexField.data() + indexField.size();
+        if (indexField.empty() || std::from_chars(indexField.data(), indexEnd, index).ptr != indexEnd)
+            throw invalid();
+        const auto code = next();
+        const turing_rule rule = turing_rule::parse(code);
+        if (rule.empty() || rule.str() != code)
+            throw invalid();
+        auto r = make(index, category, rule);
+        while (!line.empty())
+        {
+            const auto field = next();
+            if (r.numFields == maxFields)
+                throw invalid();
+            if (field == "?")
+            {
+                r.add(unknown);
+                continue;
+            }
+            int64_t x = 0;
+            const auto *fieldEnd = field.data() + field.size();
+            if (field.empty() || std::from_chars(field.data(), fieldEnd, x).ptr != fieldEnd)
+                throw invalid();
+            r.add(x);
+        }
+        return r;
+    }
+};
+static_assert(sizeof(seed_record) == 64);
+static_assert(std::endian::native == std::endian::little);
+
+/// Writes the header of a seed database.
+inline void writeHeader(std::ostream &out)
+{
+    std::array<char, headerSize> header{};
+    std::ranges::copy(magic, header.begin());
+    std::memcpy(header.data() + 8, &version, sizeof(version));
+    const auto recordSize = (uint32_t)sizeof(seed_record);
+    std::memcpy(header.data() + 12, &recordSize, sizeof(recordSize));
+    out.write(header.data(), headerSize);
+}
+
+inline void write(std::ostream &out, const seed_record &r) { out.write((const char *)&r, sizeof(r)); }
+
+/// A memory-mapped seed database.
+class Database
+{
+  public:
+    /// Throws `std::runtime_error` if the file can't be read or is not a seed database.
+    explicit Database(const std::filesystem::path &path) : Database(MappedFile{path}, path) {}
+
+    /// Reads a seed database from a mapped file. `path` is only used in error messages.
+    Database(MappedFile file, const std::filesystem::path &path) : _file(std::move(file))
+    {
+        uint32_t v = 0;
+        uint32_t recordSize = 0;
+        if (_file.size() < headerSize || std::memcmp(_file.data(), magic.data(), magic.size()) != 0)
+            throw std::runtime_error("Not a seed database: " + path.string());
+        std::memcpy(&v, _file.data() + 8, sizeof(v));
+        std::memcpy(&recordSize, _file.data() + 12, sizeof(recordSize));
+        if (v != version || recordSize != sizeof(seed_record))
+            throw std::runtime_error("Unsupported seed database version " + std::to_string(v));
+        if ((_file.size() - headerSize) % sizeof(seed_record) != 0)
+            throw std::runtime_error("Truncated seed database: " + path.string());
+    }
+
+    [[nodiscard]] size_t size() const { return (_file.size() - headerSize) / sizeof(seed_record); }
+    [[nodiscard]] std::span<const seed_record> records() const
+    {
+        return {(const seed_record *)(_file.data() + headerSize), size()};
+    }
+    [[nodiscard]] const seed_record &operator[](size_t i) const { return records()[i]; }
+    [[nodiscard]] auto begin() const { return records().begin(); }
+    [[nodiscard]] auto end() const { return records().end(); }
+
+  private:
+    MappedFile _file;
+};
+} // namespace seeds
+} // namespace turing
@@ -1,18 +1,60 @@
 #include "pch.hpp"
 
+#include "engine/compiled.hpp"
+#include "engine/macro.hpp"
+#include "engine/proof.hpp"
+#include "engine/rle.hpp"
+#include "snapshot.hpp"
+
 using namespace std;
 using namespace turing;
 
-auto run(turing_rule rule, size_t numSteps, bool verbose)
+/// Runs m until step `numSteps`. If `snapshotPath` is nonempty, saves a snapshot there every `snapshotEvery` steps and
+/// at the end.
+auto run(TuringMachine m, size_t numSteps, bool verbose, const string &snapshotPath, size_t snapshotEvery)
 {
-    TuringMachine m{rule};
+    const auto rule = m.rule();
+    if (!verbose)
+    {
+        while (m.steps() < numSteps && !m.halted())
+        {
+            m.stepN(min(snapshotEvery, numSteps - m.steps()));
+            if (!snapshotPath.empty())
+                snapshot::save(m, snapshotPath);
+        }
+        return pair{m.steps(), m.tape()};
+    }
     array<array<size_t, maxSymbols>, maxStates> counts{};
     while (m.steps() < numSteps)
     {
-        if (verbose)
-            ++counts[m.state()][*m.tape()];
+        ++counts[m.state()][*m.tape()];
         if (!m.step().success)
             break;
+        if (!snapshotPath.empty() && m.steps() % snapshotEvery == 0)
+            snapshot::save(m, snapshotPath);
+    }
+    if (!snapshotPath.empty())
+        snapshot::save(m, snapshotPath);
+    cout << "Transcript histogram:\n\n";
+    table(range('A', (char)('A' + rule.numStates() - 1)), range(0, rule.numSymbols() - 1),
+          fun2(s, j, counts[s - 'A'][j]))
+        << '\n';
+    return pair{m.steps(), m.tape()};
+}
+
+auto runRLE(turing_rule rule, size_t numSteps, bool verbose)
+{
+    RLETuringMachine m{rule};
+    array<array<size_t, maxSymbols>, maxStates> counts{};
+    while (m.steps() < numSteps)
+    {
+        const auto state = m.state();
+        const auto symbol = *m.tape();
+        const auto steps = m.steps();
+        if (!m.step(numSteps - m.steps()).success)
+            break;
+        if (verbose)
+            counts[state][symbol] += m.steps() - steps;
     }
     if (verbose)
     {
@@ -24,24 +66,111 @@ auto run(turing_rule rule, size_t numSteps, bool verbose)
     return pair{m.steps(), m.tape()};
 }
 
+auto runMacro(turing_rule rule, size_t numSteps, size_t blockSize, bool verbose)
+{
+    if (blockSize == 0)
+    {
+        if (verbose)
+            cout << "Probing block sizes:\n";
+        blockSize = findBlockSize(rule, min(numSteps, 100'000UZ), 24, verbose);
+    }
+    MacroTuringMachine m{rule, blockSize};
+    m.seek(numSteps);
+    const auto &stats = m.stats();
+    cout << "block size = " << blockSize << " | macro steps = " << stats.macroSteps << " | real steps = " << m.steps()
+         << " | cache size = " << m.cacheSize() << " | cache hit rate = " << 100 * stats.hitRate() << "%\n";
+    return pair{m.steps(), m.str()};
+}
+
+auto runProof(turing_rule rule, size_t maxIterations, size_t blockSize, bool verbose)
+{
+    if (blockSize == 0)
+    {
+        if (verbose)
+            cout << "Probing block sizes:\n";
+        blockSize = findProofBlockSize(rule, min(maxIterations, 10'000UZ), 8, verbose);
+    }
+    ProofTuringMachine m{rule, blockSize};
+    m.run(maxIterations);
+    const auto &stats = m.stats();
+    cout << "block size = " << blockSize << " | macro steps = " << stats.macroSteps
+         << " | rules proven = " << stats.rulesProven << " | rule applications = " << stats.ruleApplications << '\n';
+    switch (m.status())
+    {
+    case proof_status::halted:
+        cout << "Halted after " << m.steps() << " steps with sigma = " << m.sigma() << '\n';
+        break;
+    case proof_status::infinite:
+        cout << "Proven to run forever\n";
+        break;
+    case proof_status::unknown:
+        cout << "Gave up on a block transition that runs too long\n";
+        break;
+    case proof_status::running:
+        cout << "Still running\n";
+        break;
+    }
+    return pair{m.steps(), m.str()};
+}
+
+#ifdef TURING_COMPILED_ENGINE
+auto runCompiled(turing_rule rule, size_t numSteps, bool verbose)
+{
+    CompiledTuringMachine m{rule, {.verbose = verbose}};
+    m.seek(numSteps);
+    return pair{m.steps(), m.tape()};
+}
+#endif
+
 int main(int argc, char *argv[])
 {
     constexpr string_view help = R"(Simulates a Turing machine and outputs the final tape
 
 Usage: ./run simulate <TM> <n>
+       ./run simulate --resume <file> <n>
 
 Arguments:
   <TM>  The Turing machine
-  <n>   Number of steps
+  <n>   Number of steps (counted from the blank tape when resuming)
 
 Options:
-  -h, --help     Show this help message
-  -v, --verbose  Show more info
+  -h, --help           Show this help message
+  -e, --engine <name>  Simulation engine: basic, rle, macro, proof or compiled
+                       (default: basic)
+  -k, --block-size <n> Block size of the macro and proof engines (default:
+                       chosen by probing)
+  -o, --snapshot <file>
+                       Periodically save a snapshot of the machine to a file
+  --snapshot-every <n> Steps between snapshots (default: 10000000000)
+  -r, --resume <file>  Start from a snapshot instead of a blank tape
+  -v, --verbose        Show more info
+
+Comments:
+  The rle engine stores the tape as runs of symbols and crosses a whole run in
+  one step when a transition loops back to the same state.
+  The macro engine treats blocks of k cells as one symbol and memoizes block
+  transitions as they are discovered.
+  The proof engine stores the tape as runs of blocks with arbitrary-precision
+  exponents and proves and applies general rules, so it can finish machines
+  that run for far more steps than can be simulated. <n> is the number of
+  iterations to run rather than the number of steps.
+  The compiled engine generates C++ code for the machine, compiles it with
+  $TURING_CXX (default: clang++) into a shared object and loads it, so it is
+  only available where shared objects can be loaded with dlopen. Shared
+  objects are cached by rule, compiler and flags in $TURING_CACHE_DIR
+  (default: a turing-compiled folder in the temporary directory).
+  Snapshots are only supported by the basic engine. They can also be loaded by
+  analyze and tape_growth.
 )";
     const span args(argv, argc);
     turing_rule rule;
     size_t numSteps = 0;
     bool verbose = false;
+    string_view engine = "basic";
+    size_t blockSize = 0;
+    string snapshotPath;
+    size_t snapshotEvery = 10'000'000'000;
+    string resumePath;
     int argPos = 0;
     for (int i = 1; i < argc; ++i)
     {
@@ -52,6 +181,34 @@ Options:
         }
         if (strcmp(args[i], "-v") == 0 || strcmp(args[i], "--verbose") == 0)
             verbose = true;
+        else if (strcmp(args[i], "-e") == 0 || strcmp(args[i], "--engine") == 0)
+        {
+            engine = args[++i];
+            if (engine != "basic" && engine != "rle" && engine != "macro" && engine != "proof" &&
+                engine != "compiled")
+            {
+                cerr << ansi::red << "Unknown engine: " << ansi::reset << engine << '\n' << help;
+                return 0;
+            }
+#ifndef TURING_COMPILED_ENGINE
+            if (engine == "compiled")
+            {
+                cerr << ansi::red << "Engine not available: " << ansi::reset << engine << " (it needs dlopen)\n";
+                return 0;
+            }
+#endif
+        }
+        else if (strcmp(args[i], "-k") == 0 || strcmp(args[i], "--block-size") == 0)
+            blockSize = parseNumber(args[++i]);
+        else if (strcmp(args[i], "-o") == 0 || strcmp(args[i], "--snapshot") == 0)
+            snapshotPath = args[++i];
+        else if (strcmp(args[i], "--snapshot-every") == 0)
+            snapshotEvery = max(parseNumber(args[++i]), 1UZ);
+        else if (strcmp(args[i], "-r") == 0 || strcmp(args[i], "--resume") == 0)
+        {
+            resumePath = args[++i];
+            argPos = max(argPos, 1);
+        }
         else if (argPos == 0)
         {
             ++argPos;
@@ -73,11 +230,49 @@ Options:
             return 0;
         }
     }
+    if (!resumePath.empty() && !rule.empty())
+    {
+        cerr << ansi::red << "Unexpected TM with --resume" << ansi::reset << '\n' << help;
+        return 0;
+    }
+    TuringMachine start{rule};
+    if (!resumePath.empty())
+    {
+        try
+        {
+            start = snapshot::load(resumePath);
+        }
+        catch (const exception &e)
+        {
+            cerr << ansi::red << e.what() << ansi::reset << '\n';
+            return 1;
+        }
+        rule = start.rule();
+        cout << "Resuming " << rule.str() << " from step " << start.steps() << '\n';
+    }
     if (rule.empty())
     {
         cout << help;
         return 0;
     }
+    if (engine != "basic" && (!snapshotPath.empty() || !resumePath.empty()))
+    {
+        cerr << ansi::red << "Snapshots are only supported by the basic engine" << ansi::reset << '\n';
+        return 0;
+    }
+    if (snapshotPath.empty())
+        snapshotEvery = numeric_limits<size_t>::max();
     ios::sync_with_stdio(false);
-    printTiming(run, rule, numSteps, verbose);
+    if (engine == "rle")
+        printTiming(runRLE, rule, numSteps, verbose);
+    else if (engine == "macro")
+        printTiming(runMacro, rule, numSteps, blockSize, verbose);
+    else if (engine == "proof")
+        printTiming(runProof, rule, numSteps, blockSize, verbose);
+#ifdef TURING_COMPILED_ENGINE
+    else if (engine == "compiled")
+        printTiming(runCompiled, rule, numSteps, verbose);
+#endif
+    else
+        printTiming(run, std::move(start), numSteps, verbose, snapshotPath, snapshotEvery);
 }
@@ -0,0 +1,297 @@
+#pragma once
+
+#include <cerrno>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+
+#include "turing.hpp"
+
+#if __has_include(<fcntl.h>) && __has_include(<unistd.h>)
+#define TURING_DURABLE_FILES
+
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace turing
+{
+/// Reading and writing snapshots of a Turing machine in the middle of a run, so that long simulations can be resumed
+/// and other tools can start from where an expensive run left off.
+///
+/// The format is little-endian binary:
+///
+///     magic "TMSNAP" | version u8 | reserved u8
+///     rule code length u16 | rule code in TNF
+///     state i32 | steps u64 | head i64 | left edge i64 | number of runs u64
+///     runs of (symbol u8, length as LEB128)
+///     FNV-1a hash u64 of everything above
+///
+/// The tape is stored from its left edge to its right edge, run-length encoded, so a tape of long blocks like the
+/// ones of `known::antihydra()` takes a few bytes per block.
+namespace snapshot
+{
+constexpr std::string_view magic = "TMSNAP";
+constexpr uint8_t version = 1;
+
+namespace detail
+{
+constexpr uint64_t fnvOffset = 0xcbf29ce484222325;
+constexpr uint64_t fnvPrime = 0x100000001b3;
+} // namespace detail
+
+/// Little-endian binary output with a trailing FNV-1a hash, for snapshots and other binary files.
+class writer
+{
+  public:
+    template <typename T> void put(T x)
+    {
+        for (size_t i = 0; i < sizeof(T); ++i)
+            byte((uint8_t)((uint64_t)x >> 8 * i));
+    }
+
+    void putVarint(uint64_t x)
+    {
+        for (; x >= 0x80; x >>= 7)
+            byte((uint8_t)(x | 0x80));
+        byte((uint8_t)x);
+    }
+
+    void putBytes(std::string_view s)
+    {
+        for (char c : s)
+            byte((uint8_t)c);
+    }
+
+    /// Appends the hash and returns the bytes.
+    std::string finish() &&
+    {
+        put(_hash);
+        return std::move(_buf);
+    }
+
+  private:
+    std::string _buf;
+    uint64_t _hash = detail::fnvOffset;
+
+    void byte(uint8_t b)
+    {
+        _buf += (char)b;
+        _hash = (_hash ^ b) * detail::fnvPrime;
+    }
+};
+
+/// Reads data written by `writer`. Throws `std::runtime_error` if the data is truncated or corrupt.
+class reader
+{
+  public:
+    explicit reader(std::string_view data) : _data(data) {}
+
+    template <typename T> T get()
+    {
+        uint64_t x = 0;
+        for (size_t i = 0; i < sizeof(T); ++i)
+            x |= (uint64_t)byte() << 8 * i;
+        return (T)x;
+    }
+
+    uint64_t getVarint()
+    {
+        uint64_t x = 0;
+        for (size_t shift = 0; shift < 64; shift += 7)
+        {
+            const uint8_t b = byte();
+            x |= (uint64_t)(b & 0x7F) << shift;
+            if ((b & 0x80) == 0)
+                return x;
+        }
+        throw std::runtime_error("Corrupt snapshot: bad length");
+    }
+
+    std::string_view getBytes(size_t n)
+    {
+        if (_pos + n > _data.size())
+            throw std::runtime_error("Corrupt snapshot: truncated");
+        for (size_t i = 0; i < n; ++i)
+            _hash = (_hash ^ (uint8_t)_data[_pos + i]) * detail::fnvPrime;
+        _pos += n;
+        return _data.substr(_pos - n, n);
+    }
+
+    /// Checks the trailing hash against all the bytes before it, before any of them are read, so that corrupt data is
+    /// rejected before it is interpreted.
+    void verify() const
+    {
+        if (_data.size() < sizeof(uint64_t))
+            throw std::runtime_error("Corrupt snapshot: truncated");
+        const auto end = _data.size() - sizeof(uint64_t);
+        uint64_t hash = detail::fnvOffset;
+        for (size_t i = 0; i < end; ++i)
+            hash = (hash ^ (uint8_t)_data[i]) * detail::fnvPrime;
+        uint64_t expected = 0;
+        for (size_t i = 0; i < sizeof(uint64_t); ++i)
+            expected |= (uint64_t)(uint8_t)_data[end + i] << 8 * i;
+        if (hash != expected)
+            throw std::runtime_error("Corrupt snapshot: checksum mismatch");
+    }
+
+    /// Reads the trailing hash and checks it against the bytes read so far.
+    void finish()
+    {
+        const auto expected = _hash;
+        if (get<uint64_t>() != expected || _pos != _data.size())
+            throw std::runtime_error("Corrupt snapshot: checksum mismatch");
+    }
+
+  private:
+    std::string_view _data;
+    size_t _pos = 0;
+    uint64_t _hash = detail::fnvOffset;
+
+    uint8_t byte()
+    {
+        if (_pos >= _data.size())
+            throw std::runtime_error("Corrupt snapshot: truncated");
+        const auto b = (uint8_t)_data[_pos++];
+        _hash = (_hash ^ b) * detail::fnvPrime;
+        return b;
+    }
+};
+
+/// Serializes the machine. Works with any machine whose tape has `leftEdge()`, `rightEdge()` and `operator[]`.
+template <typename Machine> std::string encode(const Machine &m)
+{
+    const auto &tape = m.tape();
+    const auto code = m.rule().str();
+    writer w;
+    w.putBytes(magic);
+    w.put(version);
+    w.put(uint8_t{0});
+    w.put((uint16_t)code.size());
+    w.putBytes(code);
+    w.put((int32_t)m.state());
+    w.put((uint64_t)m.steps());
+    w.put((int64_t)tape.head());
+    w.put((int64_t)tape.leftEdge());
+
+    std::vector<std::pair<symbol_type, uint64_t>> runs;
+    for (int64_t i = tape.leftEdge(); i <= tape.rightEdge(); ++i)
+        if (!runs.empty() && runs.back().first == tape[i])
+            ++runs.back().second;
+        else
+            runs.emplace_back(tape[i], 1);
+    w.put((uint64_t)runs.size());
+    for (auto &&[symbol, length] : runs)
+    {
+        w.put(symbol);
+        w.putVarint(length);
+    }
+    return std::move(w).finish();
+}
+
+/// Deserializes a machine written by `encode`. Throws `std::runtime_error` if the data is not a valid snapshot.
+inline TuringMachine decode(std::string_view data)
+{
+    reader r{data};
+    if (r.getBytes(magic.size()) != magic)
+        throw std::runtime_error("Not a snapshot");
+    r.verify();
+    if (const auto v = r.get<uint8_t>(); v != version)
+        throw std::runtime_error("Unsupported snapshot version " + std::to_string(v));
+    r.get<uint8_t>();
+    const turing_rule rule{std::string(r.getBytes(r.get<uint16_t>()))};
+    if (rule.empty())
+        throw std::runtime_error("Corrupt snapshot: invalid rule");
+    const auto state = r.get<int32_t>();
+    // A machine is in a state of its rule, or has halted on an undefined transition (-1) or in Z
+    if ((state < 0 || state >= (int32_t)rule.numStates()) && state != -1 && state != 'Z' - 'A')
+        throw std::runtime_error("Corrupt snapshot: invalid state");
+    const auto steps = r.get<uint64_t>();
+    const auto head = r.get<int64_t>();
+    const auto leftEdge = r.get<int64_t>();
+
+    // The head visits at most one new cell a step
+    const uint64_t maxCells = std::min<uint64_t>(steps, 1UZ << 40) + 1;
+    Tape::container_type cells;
+    for (auto n = r.get<uint64_t>(); n > 0; --n)
+    {
+        const auto symbol = r.get<symbol_type>();
+        const auto length = r.getVarint();
+        if (symbol >= rule.numSymbols() || length > maxCells - cells.size())
+            throw std::runtime_error("Corrupt snapshot: invalid tape");
+        cells.insert(cells.end(), length, symbol);
+    }
+    r.finish();
+    if (head < leftEdge || head >= leftEdge + (int64_t)cells.size())
+        throw std::runtime_error("Corrupt snapshot: head outside the tape");
+    return {rule, Tape{std::move(cells), leftEdge, head, (state_type)state}, steps};
+}
+
+/// Replaces the file at `path` with `bytes`, so that even a crash of the whole system leaves either the old file or the
+/// new one. The bytes are written to a temporary file, which is flushed to disk before it is renamed to `path`, and
+/// the directory is flushed after the rename. Without POSIX files, only the rename protects it. Throws
+/// `std::runtime_error` on I/O errors, calling the file `what`.
+inline void writeFileAtomically(const std::filesystem::path &path, std::string_view bytes, std::string_view what)
+{
+    auto tmp = path;
+    tmp += ".tmp";
+    const auto fail = [&](const std::filesystem::path &p) {
+        throw std::runtime_error("Failed to write " + std::string(what) + " " + p.string());
+    };
+#ifdef TURING_DURABLE_FILES
+    const int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        fail(tmp);
+    for (size_t written = 0; written < bytes.size();)
+    {
+        const auto n = ::write(fd, bytes.data() + written, bytes.size() - written);
+        if (n < 0 && errno != EINTR)
+        {
+            ::close(fd);
+            fail(tmp);
+        }
+        written += n < 0 ? 0 : (size_t)n;
+    }
+    const bool synced = ::fsync(fd) == 0;
+    if (::close(fd) != 0 || !synced)
+        fail(tmp);
+#else
+    {
+        std::ofstream fout(tmp, std::ios::binary | std::ios::trunc);
+        fout.write(bytes.data(), (std::streamsize)bytes.size());
+        fout.flush();
+        if (!fout)
+            fail(tmp);
+    }
+#endif
+    std::filesystem::rename(tmp, path);
+#ifdef TURING_DURABLE_FILES
+    const auto directory = path.has_parent_path() ? path.parent_path() : std::filesystem::path(".");
+    const int dirFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (dirFd < 0)
+        fail(directory);
+    const bool dirSynced = ::fsync(dirFd) == 0;
+    ::close(dirFd);
+    if (!dirSynced)
+        fail(directory);
+#endif
+}
+
+/// Writes a snapshot of the machine to `path` with `writeFileAtomically`, so a crash never leaves a partially written
+/// snapshot behind. Throws `std::runtime_error` on I/O errors.
+template <typename Machine> void save(const Machine &m, const std::filesystem::path &path)
+{
+    writeFileAtomically(path, encode(m), "snapshot");
+}
+
+/// Reads a snapshot from `path`. Throws `std::runtime_error` if the file can't be read or is not a valid snapshot.
+inline TuringMachine load(const std::filesystem::path &path)
+{
+    std::ifstream fin(path, std::ios::binary);
+    if (!fin)
+        throw std::runtime_error("Failed to open snapshot " + path.string());
+    const std::string bytes{std::istreambuf_iterator<char>(fin), {}};
+    return decode(bytes);
+}
+} // namespace snapshot
+} // namespace turing
@@ -3,10 +3,13 @@
 #include "pch.hpp"
 #include "turing.hpp"
 
+#include "engine/rle.hpp"
+#include "snapshot.hpp"
+
 using namespace std;
 using namespace turing;
 
-ostream &print(const TuringMachine &m)
+template <typename Machine> ostream &print(const Machine &m)
 {
     cout << setw(6) << m.tape().size() << " | " << setw(10) << m.steps();
     cout << " | " << m.prettyStr(80) << '\n';
@@ -24,17 +27,22 @@ string formatDelta(size_t a, size_t b)
     return std::move(ss).str();
 }
 
-auto run(turing_rule rule, int growDir, state_type state, size_t numSteps, bool allDeltas)
+template <typename Machine> auto run(Machine m, int growDir, state_type state, size_t numSteps, bool allDeltas)
 {
-    TuringMachine m{rule};
-    vector<size_t> lSteps{0};
-    vector<size_t> rSteps{0};
+    const auto rule = m.rule();
+    numSteps += m.steps();
+    vector<size_t> lSteps{m.steps()};
+    vector<size_t> rSteps{m.steps()};
     cout << fixed << setprecision(10);
     cout << "  | " << setw(13) << "initial tape" << " | ";
     print(m);
     while (!m.halted() && m.steps() < numSteps)
     {
-        auto res = m.step();
+        TuringMachine::step_result res;
+        if constexpr (std::same_as<Machine, RLETuringMachine>)
+            res = m.step(numSteps - m.steps());
+        else
+            res = m.step();
         if (!res.tapeExpanded || (state != -1 && m.state() != state))
             continue;
         // Tape grew
@@ -78,6 +86,7 @@ int main(int argc, char *argv[])
     constexpr string_view help = R"(Tape growth tool
 
 Usage: ./run tape_growth <TM>
+       ./run tape_growth --from <file>
 
 Arguments:
   <TM>  The Turing machine.
@@ -88,6 +97,9 @@ Options:
   -s, --side <L|R>            Measure left or right side (default: both)
   -s, --state <A|B|...>       Match state (default: all states)
   -n, --num-steps <number>    Maximum number of steps (default: 1000000)
+  -e, --engine <name>         Simulation engine: basic or rle (default: basic)
+  --from <file>               Start from a snapshot saved by simulate instead of
+                              a blank tape (basic engine only)
 )";
     const span args(argv, argc);
     turing_rule rule;
@@ -95,6 +107,8 @@ Options:
     state_type matchState = -1;
     size_t numSteps = 1'000'000;
     bool allDeltas = false;
+    bool rle = false;
+    string fromPath;
     for (int i = 1; i < argc; ++i)
     {
         if (strcmp(args[i], "-h") == 0 || strcmp(args[i], "--help") == 0)
@@ -115,6 +129,18 @@ Options:
             matchState = toupper(args[++i][0]) - 'A';
         else if (strcmp(args[i], "-n") == 0 || strcmp(args[i], "--num-steps") == 0)
             numSteps = parseNumber(args[++i]);
+        else if (strcmp(args[i], "-e") == 0 || strcmp(args[i], "--engine") == 0)
+        {
+            const string_view engine = args[++i];
+            if (engine != "basic" && engine != "rle")
+            {
+                cerr << ansi::red << "Unknown engine: " << ansi::reset << engine << '\n' << help;
+                return 0;
+            }
+            rle = engine == "rle";
+        }
+        else if (strcmp(args[i], "--from") == 0)
+            fromPath = args[++i];
         else if (rule.empty())
         {
             rule = turing_rule(args[i]);
@@ -130,10 +156,32 @@ Options:
             return 0;
         }
     }
+    TuringMachine start{rule};
+    if (!fromPath.empty())
+    {
+        if (rle)
+        {
+            cerr << ansi::red << "Snapshots are only supported by the basic engine" << ansi::reset << '\n';
+            return 0;
+        }
+        try
+        {
+            start = snapshot::load(fromPath);
+        }
+        catch (const exception &e)
+        {
+            cerr << ansi::red << e.what() << ansi::reset << '\n';
+            return 1;
+        }
+        rule = start.rule();
+    }
     if (rule.empty())
     {
         cout << help;
         return 0;
     }
-    printTiming(run, rule, growDir, matchState, numSteps, allDeltas);
+    if (rle)
+        printTiming(run<RLETuringMachine>, RLETuringMachine{rule}, growDir, matchState, numSteps, allDeltas);
+    else
+        printTiming(run<TuringMachine>, std::move(start), growDir, matchState, numSteps, allDeltas);
 }
@@ -1,4 +1,5 @@
 #include "pch.hpp"
+#include "machine_db.hpp"
 #include "turing.hpp"
 
 using namespace std;
@@ -7,35 +8,55 @@ using namespace turing;
 double interpolateTapeSize(TuringMachine m, size_t steps)
 {
     size_t stepsBefore = 0;
-    size_t stepsAfter = 0;
-    for (size_t i = 0; i < steps; ++i)
-        if (m.step().tapeExpanded)
+    bool expanded = false;
+    const auto untilExpanded = [&](const step_info &info) { return expanded = info.tapeExpanded; };
+    const transition_table table{m.rule()};
+    while (m.steps() < steps && m.runUntil(table, untilExpanded, steps - m.steps()) != 0)
+        if (expanded)
             stepsBefore = m.steps();
     size_t tapeSize = m.tape().size();
-    while (true)
-    {
-        auto res = m.step();
-        if (!res.success)
-            return 0;
-        if (res.tapeExpanded)
-        {
-            stepsAfter = m.steps();
-            break;
-        }
-    }
+    expanded = false;
+    m.runUntil(table, untilExpanded);
+    if (!expanded)
+        return 0;
+    const size_t stepsAfter = m.steps();
     return (double)tapeSize + (double)(steps - stepsBefore) / (stepsAfter - stepsBefore);
 }
 
-auto run(size_t steps)
+/// The number of tape sizes of distinct machines that are remembered, so that machines isomorphic to one of them
+/// aren't simulated again.
+constexpr size_t maxCached = 1 << 22;
+
+auto run(size_t steps, const string &dbPath, const string &indexPath, pair<size_t, size_t> range)
 {
     ofstream fout("out/out.txt");
     fout << fixed << setprecision(10);
     cout << fixed << setprecision(10);
-    it::lines("data/in.txt")([&](auto &&code) {
-        double res = interpolateTapeSize({code}, steps);
+    const auto output = [&](const string &code, double res) {
         cout << code << " | " << res << '\n';
         fout << res << '\n' << flush;
-    });
+    };
+    // Machines that differ by renaming states or symbols, or by mirroring, have the same tape sizes
+    boost::unordered_flat_map<uint64_t, double> cache;
+    const auto tapeSize = [&](const turing_rule &rule) {
+        const auto id = canonicalId(rule);
+        if (const auto found = cache.find(id); found != cache.end())
+            return found->second;
+        if (cache.size() == maxCached)
+            cache.clear();
+        return cache[id] = interpolateTapeSize({rule}, steps);
+    };
+    if (dbPath.empty())
+    {
+        it::lines("data/in.txt")([&](auto &&code) { output(code, tapeSize(turing_rule{code})); });
+        return;
+    }
+    const MachineDatabase db{dbPath};
+    optional<MachineIndex> index;
+    if (!indexPath.empty())
+        index.emplace(indexPath);
+    forEachMachine(db, index ? &*index : nullptr, range.first, range.second,
+                   [&](uint64_t, const turing_rule &rule) { output(rule.str(), tapeSize(rule)); });
 }
 
 int main(int argc, char *argv[])
@@ -48,15 +69,27 @@ Arguments:
   <n>  Step number.
 
 Options:
-  -h, --help  Show this help message
+  -h, --help          Show this help message
+  -d, --db <file>     Read the machines from a binary database instead: a
+                      bbchallenge database of 5-state machines, or a seed
+                      database written by enumerate
+  -i, --index <file>  Only read the machines of the database listed in an index
+                      file of big-endian 32-bit machine IDs
+  -r, --range <a>..<b>
+                      Only read entries a to b - 1 of the index, or of the
+                      database if there is no index
 
 Comments:
   The program reads a list of Turing machines from data/in.txt and outputs the
   corresponding list of tape sizes to both the console (Standard Output) and a
-  file named out/out.txt.
+  file named out/out.txt. Machines that are the same up to renaming states or
+  symbols, or mirroring, are only simulated once.
 )";
     span args(argv, argc);
     size_t steps = 0;
+    string dbPath;
+    string indexPath;
+    pair<size_t, size_t> range{0, numeric_limits<size_t>::max()};
     for (int i = 1; i < argc; ++i)
     {
         if (strcmp(args[i], "-h") == 0 || strcmp(args[i], "--help") == 0)
@@ -64,7 +97,22 @@ Comments:
             cout << help;
             return 0;
         }
-        if (steps == 0)
+        if (strcmp(args[i], "-d") == 0 || strcmp(args[i], "--db") == 0)
+            dbPath = args[++i];
+        else if (strcmp(args[i], "-i") == 0 || strcmp(args[i], "--index") == 0)
+            indexPath = args[++i];
+        else if (strcmp(args[i], "-r") == 0 || strcmp(args[i], "--range") == 0)
+        {
+            const string arg = args[++i];
+            const auto dots = arg.find("..");
+            if (dots == string::npos)
+            {
+                cerr << ansi::red << "Invalid range: " << ansi::reset << arg << '\n';
+                return 1;
+            }
+            range = {parseNumber(arg.substr(0, dots)), parseNumber(arg.substr(dots + 2))};
+        }
+        else if (steps == 0)
             steps = parseNumber(args[i]);
     }
     if (steps == 0)
@@ -73,5 +121,13 @@ Comments:
         return 0;
     }
     ios::sync_with_stdio(false);
-    printTiming(run, steps);
+    try
+    {
+        printTiming(run, steps, dbPath, indexPath, range);
+    }
+    catch (const runtime_error &e)
+    {
+        cerr << ansi::red << e.what() << ansi::reset << '\n';
+        return 1;
+    }
 }
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#include <ansi.hpp>
+
+#if __has_include(<sys/socket.h>) && __has_include(<sys/un.h>)
+#define TURING_UNIX_SOCKETS
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+namespace turing
+{
+/// A destination for telemetry, written as one JSON object per line: a file that the lines are appended to, or a Unix
+/// domain socket given as `unix:<path>` that a monitor listens on. A failed write is reported once and later lines are
+/// dropped, so a monitor going away doesn't stop a long run.
+class TelemetrySink
+{
+  public:
+    /// Throws `std::runtime_error` if the destination can't be opened.
+    explicit TelemetrySink(const std::string &destination)
+    {
+        constexpr std::string_view unixPrefix = "unix:";
+        if (!destination.starts_with(unixPrefix))
+        {
+            _file.open(destination, std::ios::app);
+            if (!_file)
+                throw std::runtime_error("Failed to open " + destination);
+            return;
+        }
+#ifdef TURING_UNIX_SOCKETS
+        const auto path = destination.substr(unixPrefix.size());
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(address.sun_path))
+            throw std::runtime_error("Socket path too long: " + path);
+        path.copy(address.sun_path, path.size());
+        _socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        if (_socket < 0 || ::connect(_socket, (const sockaddr *)&address, sizeof(address)) != 0)
+        {
+            if (_socket >= 0)
+                ::close(_socket);
+            throw std::runtime_error("Failed to connect to " + path);
+        }
+#else
+        throw std::runtime_error("Unix sockets are not supported on this platform");
+#endif
+    }
+
+    TelemetrySink(const TelemetrySink &) = delete;
+    TelemetrySink &operator=(const TelemetrySink &) = delete;
+
+    ~TelemetrySink()
+    {
+#ifdef TURING_UNIX_SOCKETS
+        if (_socket >= 0)
+            ::close(_socket);
+#endif
+    }
+
+    /// Writes a line, which must not contain a newline.
+    void write(std::string line)
+    {
+        if (_failed)
+            return;
+        line += '\n';
+        bool ok = true;
+        if (_file.is_open())
+            ok = (bool)_file.write(line.data(), (std::streamsize)line.size()).flush();
+#ifdef TURING_UNIX_SOCKETS
+        else
+        {
+#ifdef MSG_NOSIGNAL
+            constexpr int flags = MSG_NOSIGNAL;
+#else
+            constexpr int flags = 0;
+#endif
+            for (size_t sent = 0; ok && sent < line.size();)
+            {
+                const auto n = ::send(_socket, line.data() + sent, line.size() - sent, flags);
+                ok = n > 0;
+                sent += ok ? (size_t)n : 0;
+            }
+        }
+#endif
+        if (!ok)
+        {
+            std::cerr << ansi::red << "Failed to write telemetry, not writing any more" << ansi::reset << '\n';
+            _failed = true;
+        }
+    }
+
+  private:
+    std::ofstream _file;
+    int _socket = -1;
+    bool _failed = false;
+};
+
+/// The resident set size of the process in bytes, or 0 where it is unknown.
+inline size_t residentSetSize()
+{
+#if defined(__linux__) && defined(TURING_UNIX_SOCKETS)
+    std::ifstream statm("/proc/self/statm");
+    size_t pages = 0;
+    size_t resident = 0;
+    if (statm >> pages >> resident)
+        return resident * (size_t)sysconf(_SC_PAGESIZE);
+#endif
+    return 0;
+}
+
+/// `s` as a JSON string literal.
+inline std::string jsonString(std::string_view s)
+{
+    std::string res = "\"";
+    for (const char ch : s)
+    {
+        if (ch == '"' || ch == '\\')
+            res += '\\';
+        res += (unsigned char)ch < 0x20 ? ' ' : ch;
+    }
+    return res + '"';
+}
+} // namespace turing
@@ -1,5 +1,6 @@
 #include "../pch.hpp"
 
+#include "../arena.hpp"
 #include "common.hpp"
 
 using namespace std;
@@ -37,6 +38,55 @@ void testSimulation()
     pass("testSimulation");
 }
 
+void testStepN()
+{
+    auto m = known::bb5Champion();
+    assertEqual(m.stepN(47'176'869), 47'176'869);
+    assertEqual(m.halted(), false);
+    assertEqual(m.stepN(100), 1);
+    assertEqual(m.halted(), true);
+    assertEqual(m.steps(), 47'176'870);
+    assertEqual(m.head(), -12242);
+    assertEqual(m.tape().size(), 12289);
+    assertEqual(countOnes(m.tape()), 4098);
+    auto m2 = known::boydJohnson();
+    assertEqual(m2.stepN(10'000'000), 10'000'000);
+    assertEqual(m2.tape().size(), 66726);
+    pass("testStepN");
+}
+
+void testRunUntil()
+{
+    for (auto &&code : {"1RB0RC_1LB1LD_0RA0LD_1LA1RC", "1RB2LA1RA_1LB1LA2RC_1RZ1LC2RB", "1RB1LB_1LA1RZ"})
+    {
+        TuringMachine m1{code};
+        TuringMachine m2{code};
+        PackedTuringMachine<2> m3{m1.rule()};
+        for (int i = 0; i < 100'000; ++i)
+        {
+            const auto res = m1.step();
+            if (!res.success)
+                break;
+            if (res.tapeExpanded)
+            {
+                bool expanded = false;
+                const auto untilExpanded = [&](const step_info &info) { return expanded = info.tapeExpanded; };
+                m2.runUntil(untilExpanded);
+                assertEqual(expanded, true);
+                m3.runUntil(untilExpanded);
+                assertEqual(m2.steps(), m1.steps());
+                assertEqual(m3.steps(), m1.steps());
+                assertEqual(m2.str(), m1.str());
+                assertEqual(m3.str(), m1.str());
+            }
+        }
+        m2.stepN(100'000 - m2.steps());
+        assertEqual(m2.steps(), m1.steps());
+        assertEqual(m2.str(), m1.str());
+    }
+    pass("testRunUntil");
+}
+
 void testTapeSegment()
 {
     auto m = known::boydJohnson();
@@ -61,11 +111,86 @@ void testTapeSegment()
     pass("testTapeSegment");
 }
 
+void testPackedBB5()
+{
+    PackedTuringMachine<1> m{known::bb5Champion().rule()};
+    for (int i = 0; i < 47'176'869; ++i)
+        m.step();
+    assertEqual(m.halted(), false);
+    m.step();
+    assertEqual(m.halted(), true);
+    assertEqual(m.head(), -12242);
+    assertEqual(m.tape().size(), 12289);
+    assertEqual(m.tape().sigma(), 4098);
+    pass("testPackedBB5");
+}
+
+void testPackedTape()
+{
+    auto m = known::bb33_8th();
+    PackedTuringMachine<2> pm{m.rule()};
+    for (int i = 0; i < 1'000'000; ++i)
+    {
+        m.step();
+        pm.step();
+    }
+    assertEqual(pm.head(), m.head());
+    assertEqual(pm.tape().size(), m.tape().size());
+    assertEqual(pm.tape().sigma(), m.tape().sigma());
+    assertEqual(pm.str(), m.str());
+    assertEqual(PackedTape<2>{m.tape()}.str(), m.str());
+    auto prev = pm;
+    for (int i = 0; i < 1000; ++i)
+        pm.step();
+    const auto l = min(prev.tape().leftEdge() - prev.head(), pm.tape().leftEdge() - pm.head()) - 40;
+    const auto h = max(prev.tape().rightEdge() - prev.head(), pm.tape().rightEdge() - pm.head()) + 40;
+    for (int64_t i = l; i <= h; i += 7)
+        for (int64_t j = i; j <= h; j += 13)
+            assertEqual(spansEqual(prev.tape(), pm.tape(), i, j),
+                        prev.tape().getSegment(prev.head() + i, prev.head() + j).data ==
+                            pm.tape().getSegment(pm.head() + i, pm.head() + j).data);
+    pass("testPackedTape");
+}
+
+void testArenaTape()
+{
+    Arena arena;
+    const auto start = arena.mark();
+    {
+        const ArenaScope scope{arena};
+        auto m = known::bb33_8th();
+        ArenaTuringMachine am{m.rule()};
+        assertEqual(am.tape().data().get_allocator().arena() == &arena, true);
+        for (int i = 0; i < 100'000; ++i)
+        {
+            m.step();
+            am.step();
+        }
+        assertEqual(am.str(), m.str());
+        auto copy = am;
+        assertEqual(copy.tape().data().get_allocator().arena() == &arena, true);
+        copy.stepN(1000);
+        m.stepN(1000);
+        assertEqual(copy.str(), m.str());
+        assertEqual(ArenaTape{m.tape()}.str(), m.str());
+    }
+    // The scope freed what it allocated, and outside of a scope tapes use the heap
+    assertEqual(arena.mark().block == start.block && arena.mark().used == start.used, true);
+    const ArenaTape heapTape;
+    assertEqual(heapTape.data().get_allocator().arena() == nullptr, true);
+    pass("testArenaTape");
+}
+
 int main()
 {
     testParseFormat();
     testSimulation();
+    testStepN();
+    testRunUntil();
     testBB5();
     testTapeSegment();
+    testPackedBB5();
+    testPackedTape();
+    testArenaTape();
     pass("=== All basic tests passed ===");
 }
@@ -1,6 +1,7 @@
 #include "../pch.hpp"
 
 #include "../decide/bouncer.hpp"
+#include "../decide/certified_bouncer.hpp"
 #include "common.hpp"
 
 using namespace std;
@@ -47,10 +48,63 @@ void cu145()
     pass("cu145");
 }
 
+void bouncerSession()
+{
+    const BouncerDecider decider;
+    const TuringMachine m{"1RB0RC_1RC1LC_1LD1RA_0LB0LA"};
+    auto s = decider.session(m);
+    assertEqual(decider.extend(s, 2, 50, 100).found, false);
+    auto res = decider.extend(s, 2, 100000, 100);
+    assertEqual(res.start, 65);
+    assertEqual(res.xPeriod, 36);
+    // A search with other parameters continues from the records and simulation of the first one
+    const auto steps = s.m.steps();
+    res = decider.extend(s, 2, 400000, 36, 15);
+    const auto fresh = decider.find(m, 2, 400000, 36, 15);
+    assertEqual(s.m.steps() >= steps, true);
+    assertEqual(res.found, fresh.found);
+    assertEqual(res.start, fresh.start);
+    assertEqual(res.xPeriod, fresh.xPeriod);
+    assertEqual(res.steps, fresh.steps);
+    pass("bouncerSession");
+}
+
+void certifiedBouncer()
+{
+    const turing_rule rule{"1RB1LC_1RD1RB_0LD1LA_1LA1LD"};
+    const auto res = CertifiedBouncerDecider{}.find(TuringMachine{rule}, 100000);
+    assertEqual(res.found, true);
+    const auto c = bouncer_certificate::parse(res.certificate.str());
+    assertEqual(c.has_value(), true);
+    assertEqual(c->str(), res.certificate.str());
+    assertEqual(CertifiedBouncerDecider::verify(rule, *c), true);
+    // A certificate with another start or another count doesn't match the tape
+    auto wrong = *c;
+    ++wrong.start;
+    assertEqual(CertifiedBouncerDecider::verify(rule, wrong), false);
+    wrong = *c;
+    ++wrong.formula.repeaters[0].count;
+    assertEqual(CertifiedBouncerDecider::verify(rule, wrong), false);
+    // Counts that can't fit in the steps are rejected before the formula is expanded
+    for (const size_t count : {1'000'000'000'000UZ, std::numeric_limits<size_t>::max()})
+    {
+        wrong = *c;
+        wrong.formula.repeaters[0].count = count;
+        assertEqual(wrong.formula.fits(wrong.start + 1), false);
+        assertEqual(CertifiedBouncerDecider::verify(rule, wrong), false);
+    }
+    assertEqual(c->formula.fits(c->start + 1), true);
+    // A machine that halts is never certified
+    assertEqual(CertifiedBouncerDecider{}.find(TuringMachine{"1RB1LB_1LA---"}, 100000).found, false);
+    pass("certifiedBouncer");
+}
+
 int main()
 {
     setConsoleToUtf8();
     bo65();
+    bouncerSession();
+    certifiedBouncer();
     printTiming(bo145729);
     printTiming(bo83158409);
     printTiming(cu145);
@@ -0,0 +1,52 @@
+#include "../pch.hpp"
+
+#include "../decide/far.hpp"
+#include "common.hpp"
+
+using namespace std;
+using namespace turing;
+
+void farFound()
+{
+    const turing_rule rule{"1RB---_1RC1RA_1LD0RB_1LB0LC"};
+    assertEqual(FarDecider{}.find(rule, 4).found, false);
+    const auto res = FarDecider{}.find(rule, 5);
+    assertEqual(res.found, true);
+    assertEqual(res.mirrored, false);
+    assertEqual(res.dfa.str(), "01_21_34_33_22");
+    assertEqual(FarDecider::check(rule, res.dfa, false), true);
+    // Another DFA doesn't prove it
+    auto wrong = res.dfa;
+    wrong.next[4] = 1;
+    assertEqual(FarDecider::check(rule, wrong, false), false);
+    pass("farFound");
+}
+
+void farMirrored()
+{
+    const turing_rule rule{"1RB---0LA_1LB2RB1LA"};
+    const auto res = FarDecider{}.find(rule, 5);
+    assertEqual(res.found, true);
+    assertEqual(res.mirrored, true);
+    assertEqual(res.dfa.str(), "011_011");
+    assertEqual(FarDecider::check(rule, res.dfa, true), true);
+    assertEqual(FarDecider::check(FarDecider::mirror(rule), res.dfa, false), true);
+    pass("farMirrored");
+}
+
+void farHalting()
+{
+    for (const auto *code : {"1RB1RZ_1LB0RC_1LC1LA", "1RB2LB1RZ_2LA2RB1LB", "1RB1LB_1LA0LC_1RZ1LD_1RD0RA",
+                             "1RB1LC_1RC1RB_1RD0LE_1LA1LD_1RZ0LA"})
+        assertEqual(FarDecider{}.find(turing_rule{code}, 5).found, false);
+    pass("farHalting");
+}
+
+int main()
+{
+    setConsoleToUtf8();
+    farFound();
+    farMirrored();
+    printTiming(farHalting);
+    pass("=== All decide_far tests passed ===");
+}
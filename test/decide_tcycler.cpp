@@ -1,5 +1,7 @@
 #include "../pch.hpp"
 
+#include "../decide/brent_cycler.hpp"
+#include "../decide/record_tcycler.hpp"
 #include "../decide/tcycler.hpp"
 #include "common.hpp"
 
@@ -70,6 +72,82 @@ void cyclerP120()
     pass("cyclerP120");
 }
 
+void tcSession()
+{
+    const TranslatedCyclerDecider decider;
+    auto s = decider.session(known::boydJohnson());
+    assertEqual(decider.extend(s, 1000).period, 0);
+    assertEqual(decider.extend(s, 100'000).period, 0);
+    const auto steps = s.machine.steps();
+    const auto &res = decider.extend(s, 10'000'000);
+    const auto fresh = decider.findPeriodOnly(known::boydJohnson(), 10'000'000);
+    assertEqual(steps > 100'000, true);
+    assertEqual(res.period, fresh.period);
+    assertEqual(res.preperiod, fresh.preperiod);
+    assertEqual(res.offset, fresh.offset);
+    assertEqual(res.lastMachine.steps(), fresh.lastMachine.steps());
+    assertEqual(res.steps, fresh.steps);
+
+    const CyclerDecider cycler;
+    auto cs = cycler.session(TuringMachine{"1RB0RB_1LC0RD_1LA1LB_0LC1RD"});
+    assertEqual(cycler.extend(cs, 50).period, 0);
+    assertEqual(cycler.extend(cs, 2000).period, 120);
+    pass("tcSession");
+}
+
+void brentCycler()
+{
+    const BrentCyclerDecider decider;
+    auto res = decider.find(TuringMachine{"1RB---_1RC1RC_1LC1LB"}, 300);
+    assertEqual(res.period, 2);
+    assertEqual(res.preperiod, 3);
+    res = decider.find(TuringMachine{"1RB0RB_1LC0RD_1LA1LB_0LC1RD"}, 2000);
+    assertEqual(res.period, 120);
+    assertEqual(res.preperiod, 6);
+    assertEqual(decider.findPeriodOnly(TuringMachine{"1RB0RB_1LC0RD_1LA1LB_0LC1RD"}, 2000).period, 120);
+    assertEqual(decider.findPeriodOnly(TuringMachine{"1RB0RB_1LC0RD_1LA1LB_0LC1RD"}, 100).period, 0);
+    // Starting in the middle of the run
+    TuringMachine m{"1RB0RB_1LC0RD_1LA1LB_0LC1RD"};
+    m.stepN(50);
+    res = decider.find(m, 2000);
+    assertEqual(res.period, 120);
+    assertEqual(res.preperiod, 50);
+    // Translated cyclers and halting machines are not cyclers
+    assertEqual(decider.find(known::bbb4Champion(), 100'000).period, 0);
+    assertEqual(decider.find(TuringMachine{"1RB1LB_1LA1RZ"}, 100).period, 0);
+    pass("brentCycler");
+}
+
+void recordTcycler()
+{
+    const RecordTranslatedCyclerDecider decider;
+    auto res = decider.find(known::boydJohnson(), 10'000'000);
+    assertEqual(res.period, 17620);
+    assertEqual(res.preperiod, 158491);
+    assertEqual(res.offset, 118);
+    res = decider.find(known::bbb4Champion(), 50'000'000);
+    assertEqual(res.period, 1);
+    assertEqual(res.preperiod, 32779478);
+    assertEqual(res.offset, -1);
+    // Needs no period bound, unlike TranslatedCyclerDecider
+    res = decider.find(TuringMachine{"1RB0RA3LB1RB_2LA0LB1RA2RB"}, 200'000'000);
+    assertEqual(res.period, 33209131);
+    assertEqual(res.preperiod, 63141841);
+    assertEqual(res.offset, -39579);
+    assertEqual(decider.find(TuringMachine{"1RB1LB_1LA1RZ"}, 100).period, 0);
+    // The marker 10 cells behind the edge alternates between 1 and 2, so each record has the key of the one half a
+    // period before it
+    Tape::container_type cells(12, 0);
+    cells[1] = cells[11] = 1;
+    const TuringMachine m{"0LA0RC0RB_1RD------_2RD------_0RD0RE---_1LA------", Tape{std::move(cells), 0, 10, 0}};
+    assertEqual(TranslatedCyclerDecider{}.find(m, 1000).period, 42);
+    res = decider.find(m, 1000);
+    assertEqual(res.period, 42);
+    assertEqual(res.preperiod, 0);
+    assertEqual(res.offset, 2);
+    pass("recordTcycler");
+}
+
 int main()
 {
     setConsoleToUtf8();
@@ -79,5 +157,8 @@ int main()
     printTiming(p7129704);
     printTiming(p33209131);
     cyclerP2();
+    tcSession();
+    brentCycler();
+    printTiming(recordTcycler);
     pass("=== All decide_tcycler tests passed ===");
 }
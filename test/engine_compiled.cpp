@@ -0,0 +1,70 @@
+#include "../pch.hpp"
+
+#include "../engine/compiled.hpp"
+#include "common.hpp"
+
+using namespace std;
+using namespace turing;
+using Int = int64_t;
+
+#ifdef TURING_COMPILED_ENGINE
+void compiledBB5()
+{
+    CompiledTuringMachine m{known::bb5Champion().rule()};
+    m.seek(47'176'869);
+    assertEqual(m.steps(), 47'176'869);
+    assertEqual(m.halted(), false);
+    m.step();
+    assertEqual(m.halted(), true);
+    assertEqual(m.steps(), 47'176'870);
+    assertEqual(m.head(), -12242);
+    assertEqual(m.tape().size(), 12289);
+    assertEqual(m.sigma(), 4098);
+    pass("compiledBB5");
+}
+
+void compiledMatchesTape()
+{
+    for (auto &&code : {"1RB0RC_1LB1LD_0RA0LD_1LA1RC", "1RB1LC_0LA1RD_1LA0LC_0RB0RD", "1RB2LA1RA_1LB1LA2RC_1RZ1LC2RB",
+                        "1RB0RC_0LC---_1RD1RC_0LE1RA_1RD1LE"})
+    {
+        TuringMachine m{code};
+        CompiledTuringMachine cm{code};
+        for (size_t n : {1UZ, 2UZ, 10UZ, 1000UZ, 12345UZ, 1'000'000UZ})
+        {
+            m.seek(n);
+            cm.seek(n);
+            assertEqual(cm.steps(), m.steps());
+            assertEqual(cm.state(), m.state());
+            assertEqual(cm.head(), m.head());
+            assertEqual(cm.tape().leftEdge(), m.tape().leftEdge());
+            assertEqual(cm.tape().rightEdge(), m.tape().rightEdge());
+            assertEqual(cm.str(), m.str());
+        }
+    }
+    pass("compiledMatchesTape");
+}
+
+void compiledCopy()
+{
+    CompiledTuringMachine m{"1RB1LC_0LA1RD_1LA0LC_0RB0RD"};
+    m.seek(10000);
+    auto m2 = m;
+    m.seek(1'000'000);
+    m2.seek(1'000'000);
+    assertEqual(m2.str(), m.str());
+    pass("compiledCopy");
+}
+#endif
+
+int main()
+{
+#ifdef TURING_COMPILED_ENGINE
+    compiledBB5();
+    compiledMatchesTape();
+    compiledCopy();
+    pass("=== All engine_compiled tests passed ===");
+#else
+    cout << "Skipped engine_compiled tests: the compiled engine needs dlopen\n";
+#endif
+}
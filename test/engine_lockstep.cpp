@@ -0,0 +1,82 @@
+#include "../pch.hpp"
+
+#include "../decide/tcycler.hpp"
+#include "../engine/lockstep.hpp"
+#include "common.hpp"
+
+using namespace std;
+using namespace turing;
+using Int = int64_t;
+
+/// All 2-state 2-symbol rules, including halting and undefined transitions.
+vector<turing_rule> all2x2()
+{
+    constexpr array options{"0LA", "0LB", "0RA", "0RB", "1LA", "1LB", "1RA", "1RB", "1RZ", "---"};
+    vector<turing_rule> rules;
+    for (auto &&a : options)
+        for (auto &&b : options)
+            for (auto &&c : options)
+                for (auto &&d : options)
+                    rules.emplace_back(string{a} + b + "_" + c + d);
+    return rules;
+}
+
+void lockstepKnown()
+{
+    const vector<turing_rule> rules{known::bb2Champion().rule(), turing_rule{"0RB---_0LA---"},
+                                    turing_rule{"1RB---_0LA1RA"}, turing_rule{"1RA1RA_1RA1RA"}};
+    LockstepBatch batch{rules};
+    batch.run(1000);
+    assertEqual(batch.size(), 4);
+    assertEqual(batch.windowSize(), 64);
+    assertEqual(batch.status(0) == lane_status::halted, true);
+    assertEqual(batch.status(1) == lane_status::cycler, true);
+    assertEqual(batch.period(1), 2);
+    assertEqual(batch.status(2) == lane_status::halted, true);
+    assertEqual(batch.status(3) == lane_status::overflow, true);
+    pass("lockstepKnown");
+}
+
+void lockstepMatchesScalar()
+{
+    const auto rules = all2x2();
+    array<size_t, 4> counts{};
+    for (size_t i = 0; i < rules.size(); i += LockstepBatch::maxLanes)
+    {
+        const size_t n = min(LockstepBatch::maxLanes, rules.size() - i);
+        LockstepBatch batch{span{rules}.subspan(i, n)};
+        batch.run(256);
+        for (size_t l = 0; l < n; ++l)
+        {
+            const auto status = batch.status(l);
+            ++counts[(size_t)status];
+            TuringMachine m{rules[i + l]};
+            if (status == lane_status::cycler)
+            {
+                // The period must be exact, not a multiple of the true period.
+                m.seek(600);
+                const size_t period = batch.period(l);
+                assertEqual(isPeriodic(m, period), true);
+                for (size_t q = 1; q < period; ++q)
+                    if (period % q == 0)
+                        assertEqual(isPeriodic(m, q), false);
+            }
+            else if (status == lane_status::halted)
+            {
+                m.seek(256);
+                assertEqual(m.halted() || m.peek().toState == -1, true);
+            }
+        }
+    }
+    assertEqual(counts[(size_t)lane_status::running], 12);
+    assertEqual(counts[(size_t)lane_status::cycler], 322);
+    assertEqual(counts[(size_t)lane_status::halted], 3044);
+    assertEqual(counts[(size_t)lane_status::overflow], 6622);
+    pass("lockstepMatchesScalar");
+}
+
+int main()
+{
+    lockstepKnown();
+    lockstepMatchesScalar();
+}
@@ -0,0 +1,79 @@
+#include "../pch.hpp"
+
+#include "../engine/macro.hpp"
+#include "common.hpp"
+
+using namespace std;
+using namespace turing;
+using Int = int64_t;
+
+void macroBB5()
+{
+    for (size_t k : {1, 3, 6, 16, 64})
+    {
+        MacroTuringMachine m{known::bb5Champion().rule(), k};
+        m.seek(std::numeric_limits<size_t>::max());
+        assertEqual(m.halted(), true);
+        assertEqual(m.steps(), 47'176'870);
+        assertEqual(m.head(), -12242);
+        assertEqual(m.sigma(), 4098);
+    }
+    pass("macroBB5");
+}
+
+void macroMatchesTape()
+{
+    for (auto &&code : {"1RB0RC_1LB1LD_0RA0LD_1LA1RC", "1RB2LA1RA_1LB1LA2RC_1RZ1LC2RB", "1RB0RA3LB1RB_2LA0LB1RA2RB"})
+    {
+        TuringMachine m{code};
+        MacroTuringMachine mm{code, 7};
+        for (size_t n : {1UZ, 2UZ, 10UZ, 1000UZ, 12345UZ, 1'000'000UZ})
+        {
+            m.seek(n);
+            mm.seek(n);
+            assertEqual(mm.steps(), m.steps());
+            assertEqual(mm.state(), m.state());
+            assertEqual(mm.head(), m.head());
+            for (auto i = m.tape().leftEdge(); i <= m.tape().rightEdge(); ++i)
+                assertEqual(mm[i], m.tape()[i]);
+        }
+    }
+    pass("macroMatchesTape");
+}
+
+void macroLoopInBlock()
+{
+    // The head goes back and forth between the first two cells of a block forever
+    MacroTuringMachine m{"0RB---_0LA---", 4};
+    assertEqual(m.step(std::numeric_limits<size_t>::max()), false);
+    assertEqual(m.steps(), 0);
+    m.seek(1000);
+    assertEqual(m.steps(), 1000);
+    assertEqual(m.head(), 0);
+    assertEqual(m.step(std::numeric_limits<size_t>::max()), false);
+    assertEqual(m.stats().cacheMisses, 1);
+    assertEqual(m.stats().missSteps, MacroTuringMachine::maxBlockSteps + 1000);
+    pass("macroLoopInBlock");
+}
+
+void macroBB33_8th()
+{
+    const auto rule = known::bb33_8th().rule();
+    auto k = findBlockSize(rule, 100000, 24, true);
+    MacroTuringMachine m{rule, k};
+    m.seek(std::numeric_limits<size_t>::max());
+    assertEqual(m.halted(), true);
+    assertEqual(m.steps(), 1808669066);
+    cout << "k = " << k << " | macro steps = " << m.macroSteps() << " | hit rate = " << m.stats().hitRate() << '\n';
+    pass("macroBB33_8th");
+}
+
+int main()
+{
+    setConsoleToUtf8();
+    macroBB5();
+    macroMatchesTape();
+    macroLoopInBlock();
+    printTiming(macroBB33_8th);
+    pass("=== All engine_macro tests passed ===");
+}
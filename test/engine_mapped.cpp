@@ -0,0 +1,67 @@
+#include "../pch.hpp"
+
+#include "../engine/mapped.hpp"
+#include "common.hpp"
+
+using namespace std;
+using namespace turing;
+using Int = int64_t;
+
+#ifdef TURING_MAPPED_TAPE
+void mappedBB5()
+{
+    MappedTuringMachine m{known::bb5Champion().rule()};
+    m.seek(47'176'870);
+    assertEqual(m.halted(), true);
+    assertEqual(m.steps(), 47'176'870);
+    assertEqual(m.head(), -12242);
+    assertEqual(m.tape().size(), 12289);
+    assertEqual(m.tape().sigma(), 4098);
+    pass("mappedBB5");
+}
+
+void mappedMatchesTape()
+{
+    for (auto &&code : {"1RB0RC_1LB1LD_0RA0LD_1LA1RC", "1RB1LC_0LA1RD_1LA0LC_0RB0RD", "1RB2LA1RA_1LB1LA2RC_1RZ1LC2RB"})
+    {
+        TuringMachine m{code};
+        MappedTuringMachine mm{code};
+        for (size_t n : {1UZ, 2UZ, 10UZ, 1000UZ, 12345UZ, 1'000'000UZ})
+        {
+            m.seek(n);
+            mm.seek(n);
+            assertEqual(mm.state(), m.state());
+            assertEqual(mm.head(), m.head());
+            assertEqual(mm.tape().leftEdge(), m.tape().leftEdge());
+            assertEqual(mm.tape().rightEdge(), m.tape().rightEdge());
+            assertEqual(mm.str(), m.str());
+        }
+    }
+    pass("mappedMatchesTape");
+}
+
+void mappedCopy()
+{
+    MappedTuringMachine m{"1RB1LC_0LA1RD_1LA0LC_0RB0RD"};
+    m.seek(10000);
+    auto m2 = m;
+    assertEqual(spansEqual(m.tape(), m2.tape(), -100, 100), true);
+    m.seek(1'000'000);
+    assertEqual(spansEqual(m.tape(), m2.tape(), -100, 100), false);
+    m2.seek(1'000'000);
+    assertEqual(m2.str(), m.str());
+    assertEqual(spansEqual(m.tape(), m2.tape(), m.tape().leftEdge() - m.head() - 10,
+                           m.tape().rightEdge() - m.head() + 10),
+                true);
+    pass("mappedCopy");
+}
+#endif
+
+int main()
+{
+#ifdef TURING_MAPPED_TAPE
+    mappedBB5();
+    mappedMatchesTape();
+    mappedCopy();
+#endif
+}
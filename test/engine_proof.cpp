@@ -0,0 +1,125 @@
+#include "../pch.hpp"
+
+#include "../engine/proof.hpp"
+#include "common.hpp"
+
+using namespace std;
+using namespace turing;
+using Int = int64_t;
+
+/// Returns the tape of the proof engine as `Tape::str()` would, with the blanks at either end trimmed.
+string expand(const ProofTuringMachine &m)
+{
+    const auto &config = m.config();
+    const auto bits = packedBitsPerCell(m.rule().numSymbols());
+    string cells;
+    const auto append = [&](const block_run<big_int> &r) {
+        for (big_int i = 0; i < r.count; ++i)
+            for (size_t j = 0; j < m.blockSize(); ++j)
+                cells += (char)('0' + ((r.block >> (j * bits)) & ((1 << bits) - 1)));
+    };
+    for (auto &&r : config.left)
+        append(r);
+    auto head = (Int)cells.size() - (config.dir == direction::left);
+    for (auto it = config.right.rbegin(); it != config.right.rend(); ++it)
+        append(*it);
+    if (head < 0)
+    {
+        cells.insert(0, 1, '0');
+        head = 0;
+    }
+    if (head >= (Int)cells.size())
+        cells += '0';
+    const auto lo = min(cells.find_first_not_of('0'), (size_t)head);
+    const auto hi = max(cells.find_last_not_of('0') == string::npos ? 0 : cells.find_last_not_of('0'), (size_t)head);
+    return string{(char)(config.state + 'A'), ' '} + cells.substr(lo, head - lo) + '>' +
+           cells.substr(head, hi - head + 1);
+}
+
+/// Same as `expand`, for a `TuringMachine`.
+string trimmed(const TuringMachine &m)
+{
+    const auto &tape = m.tape();
+    auto lo = tape.leftEdge();
+    auto hi = tape.rightEdge();
+    while (lo < tape.head() && tape[lo] == 0)
+        ++lo;
+    while (hi > tape.head() && tape[hi] == 0)
+        --hi;
+    string s{(char)(m.state() + 'A'), ' '};
+    for (auto i = lo; i <= hi; ++i)
+    {
+        if (i == tape.head())
+            s += '>';
+        s += (char)('0' + tape[i]);
+    }
+    return s;
+}
+
+void proofHalting()
+{
+    const tuple<string, size_t, Int, Int> cases[]{
+        {known::bb4Champion().ruleStr(), 1, 107, 13},
+        {known::bb5Champion().ruleStr(), 3, 47'176'870, 4098},
+        {known::bb23Champion().ruleStr(), 1, 38, 9},
+        {"1RB2LA1RA1RA_1LB1LA3RB1RZ", 2, 3'932'964, 2050},
+        {known::bb33_8th().ruleStr(), 2, 1'808'669'066, 43925},
+    };
+    for (auto &&[code, k, steps, sigma] : cases)
+    {
+        ProofTuringMachine m{code, k};
+        m.run(1'000'000);
+        assertEqual(m.status() == proof_status::halted, true);
+        assertEqual(m.steps(), steps);
+        assertEqual(m.sigma(), sigma);
+    }
+    pass("proofHalting");
+}
+
+void proofBB33()
+{
+    ProofTuringMachine m{known::bb33Champion().rule(), 2};
+    m.run(1'000'000);
+    assertEqual(m.status() == proof_status::halted, true);
+    assertEqual(m.steps().str(), "119112334170342541");
+    assertEqual(m.sigma(), 374'676'383);
+    assertEqual(m.stats().ruleApplications > 0, true);
+    pass("proofBB33");
+}
+
+void proofInfinite()
+{
+    // Chain step into the blank tape
+    ProofTuringMachine m1{"1RA1RA_1RA1RA", 1};
+    assertEqual(m1.run(100) == proof_status::infinite, true);
+    // Rule with no decreasing exponent
+    ProofTuringMachine m2{"1RB1LA_1LA1RB", 1};
+    assertEqual(m2.run(100) == proof_status::infinite, true);
+    assertEqual(m2.stats().rulesProven, 1);
+    pass("proofInfinite");
+}
+
+void proofMatchesTuringMachine()
+{
+    for (auto &&code : {known::bb6Champion().ruleStr(), known::antihydra().ruleStr(), known::bb5Champion().ruleStr(),
+                        string{"1RB0LB_1RC1LB_0LD0RD_1LA1RD"}})
+        for (size_t k = 1; k <= 3; ++k)
+        {
+            ProofTuringMachine m{code, k};
+            TuringMachine tm{code};
+            while (m.run(20) == proof_status::running && m.steps() < 10'000'000)
+            {
+                tm.seek((size_t)m.steps());
+                assertEqual(expand(m), trimmed(tm));
+            }
+        }
+    pass("proofMatchesTuringMachine");
+}
+
+int main()
+{
+    proofHalting();
+    proofBB33();
+    proofInfinite();
+    proofMatchesTuringMachine();
+}
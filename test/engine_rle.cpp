@@ -0,0 +1,81 @@
+#include "../pch.hpp"
+
+#include "../engine/rle.hpp"
+#include "common.hpp"
+
+using namespace std;
+using namespace turing;
+using Int = int64_t;
+
+void rleBB5()
+{
+    RLETuringMachine m{known::bb5Champion().rule()};
+    m.seek(47'176'869);
+    assertEqual(m.steps(), 47'176'869);
+    assertEqual(m.halted(), false);
+    m.step(1);
+    assertEqual(m.halted(), true);
+    assertEqual(m.steps(), 47'176'870);
+    assertEqual(m.head(), -12242);
+    assertEqual(m.tape().size(), 12289);
+    assertEqual(m.tape().sigma(), 4098);
+    pass("rleBB5");
+}
+
+void rleMatchesTape()
+{
+    for (auto &&code : {"1RB0RC_1LB1LD_0RA0LD_1LA1RC", "1RB1LC_0LA1RD_1LA0LC_0RB0RD", "1RB2LA1RA_1LB1LA2RC_1RZ1LC2RB"})
+    {
+        TuringMachine m{code};
+        RLETuringMachine rm{code};
+        for (size_t n : {1UZ, 2UZ, 10UZ, 1000UZ, 12345UZ, 1'000'000UZ})
+        {
+            m.seek(n);
+            rm.seek(n);
+            assertEqual(rm.steps(), m.steps());
+            assertEqual(rm.state(), m.state());
+            assertEqual(rm.head(), m.head());
+            assertEqual(rm.tape().leftEdge(), m.tape().leftEdge());
+            assertEqual(rm.tape().rightEdge(), m.tape().rightEdge());
+            assertEqual(rm.tape().getSegment(rm.tape().leftEdge(), rm.tape().rightEdge()),
+                        m.tape().getSegment(m.tape().leftEdge(), m.tape().rightEdge()));
+        }
+    }
+    pass("rleMatchesTape");
+}
+
+void rleRunaway()
+{
+    // Runs off to the right forever in state B.
+    RLETuringMachine m{"1RB---_1RB---"};
+    m.seek(1'000'000'000'000);
+    assertEqual(m.steps(), 1'000'000'000'000);
+    assertEqual(m.head(), 1'000'000'000'000);
+    assertEqual(m.tape().sigma(), 1'000'000'000'000);
+    // Without a budget that fits a head position, the endless chain isn't taken
+    assertEqual(m.step(std::numeric_limits<size_t>::max()).success, false);
+    assertEqual(m.steps(), 1'000'000'000'000);
+    assertEqual(m.head(), 1'000'000'000'000);
+    m.seek(std::numeric_limits<size_t>::max());
+    assertEqual(m.steps(), 1'000'000'000'000);
+    pass("rleRunaway");
+}
+
+void rleBB33_8th()
+{
+    RLETuringMachine m{known::bb33_8th().rule()};
+    m.seek(std::numeric_limits<size_t>::max());
+    assertEqual(m.halted(), true);
+    assertEqual(m.steps(), 1808669066);
+    pass("rleBB33_8th");
+}
+
+int main()
+{
+    setConsoleToUtf8();
+    rleBB5();
+    rleMatchesTape();
+    rleRunaway();
+    printTiming(rleBB33_8th);
+    pass("=== All engine_rle tests passed ===");
+}
@@ -0,0 +1,53 @@
+#include "../pch.hpp"
+
+#include "../engine/specialized.hpp"
+#include "common.hpp"
+
+using namespace std;
+using namespace turing;
+using Int = int64_t;
+
+void specializedBB5()
+{
+    SpecializedTuringMachine<"1RB1LC_1RC1RB_1RD0LE_1LA1LD_1RZ0LA"> m;
+    m.seek(47'176'869);
+    assertEqual(m.steps(), 47'176'869);
+    assertEqual(m.halted(), false);
+    m.seek(100'000'000);
+    assertEqual(m.halted(), true);
+    assertEqual(m.steps(), 47'176'870);
+    assertEqual(m.head(), -12242);
+    assertEqual(m.tape().size(), 12289);
+    assertEqual(m.tape().sigma(), 4098);
+    pass("specializedBB5");
+}
+
+template <rule_string Code> void checkMatchesTape()
+{
+    TuringMachine m{string(Code.view())};
+    SpecializedTuringMachine<Code> sm;
+    for (size_t n : {1UZ, 2UZ, 10UZ, 1000UZ, 12345UZ, 1'000'000UZ})
+    {
+        m.seek(n);
+        sm.seek(n);
+        assertEqual(sm.steps(), m.steps());
+        assertEqual(sm.state(), m.state());
+        assertEqual(sm.head(), m.head());
+        assertEqual(sm.str(), m.tape().str());
+    }
+}
+
+void specializedMatchesTape()
+{
+    checkMatchesTape<"1RB0RC_1LB1LD_0RA0LD_1LA1RC">();
+    checkMatchesTape<"1RB1LC_0LA1RD_1LA0LC_0RB0RD">();
+    checkMatchesTape<"1RB2LA1RA_1LB1LA2RC_1RZ1LC2RB">();
+    checkMatchesTape<"1RB0RC_0LC---_1RD1RC_0LE1RA_1RD1LE">();
+    pass("specializedMatchesTape");
+}
+
+int main()
+{
+    specializedBB5();
+    specializedMatchesTape();
+}
@@ -0,0 +1,27 @@
+# Runs enumerate on 3x2 with 1 thread and with several, and checks that the machines of each category are the same.
+# Usage: cmake -DENUMERATE=<path> -DWORK_DIR=<dir> -P enumerate_threads.cmake
+
+foreach(threads 1 8)
+    set(dir "${WORK_DIR}/j${threads}")
+    file(REMOVE_RECURSE "${dir}")
+    file(MAKE_DIRECTORY "${dir}/out/3x2")
+    execute_process(COMMAND "${ENUMERATE}" 3 2 -j ${threads} WORKING_DIRECTORY "${dir}" OUTPUT_QUIET
+                    RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "enumerate with ${threads} threads failed: ${result}")
+    endif()
+endforeach()
+
+file(GLOB files RELATIVE "${WORK_DIR}/j1/out/3x2" "${WORK_DIR}/j1/out/3x2/*.txt")
+if(NOT files)
+    message(FATAL_ERROR "enumerate with 1 thread wrote no files")
+endif()
+foreach(file ${files})
+    execute_process(COMMAND "${CMAKE_COMMAND}" -E compare_files "${WORK_DIR}/j1/out/3x2/${file}"
+                    "${WORK_DIR}/j8/out/3x2/${file}" RESULT_VARIABLE result)
+    if(NOT result EQUAL 0)
+        message(FATAL_ERROR "${file} differs between 1 and 8 threads")
+    endif()
+    message("[PASS] ${file}")
+endforeach()
+message("[PASS] === enumerate gives the same machines with 1 and 8 threads ===")
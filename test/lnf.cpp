@@ -49,6 +49,37 @@ void lnf5x2Rotate()
     pass("lnf5x2Rotate");
 }
 
+void lnfSymbolsAndMirror()
+{
+    // Machines in tree normal form are their own normal form
+    for (auto &&code : {"1RB2LA1RA_1LB1LA2RC_1RZ1LC2RB", "1RB2LB1RZ_2LA2RB1LB", "1RB0LC_1LD1LA_0RC1RB_1LE1LB_1RB---"})
+        assertEqual(lexicalNormalForm(turing_rule{code}).str(), code);
+    // Symbols 1 and 2 swapped, states B and C swapped, and moves mirrored
+    assertEqual(lexicalNormalForm(turing_rule{"2LC2LA1RA_2LZ1LC2RB_2RC1LB2RA"}).str(), "1RB2LA1RA_1LB1LA2RC_1RZ1LC2RB");
+    assertEqual(lexicalNormalForm(turing_rule{"2RB2RZ1LB_1LA2LB1RB"}).str(), "1RB2LB1RZ_2LA2RB1LB");
+    assertEqual(lexicalNormalForm(turing_rule{"1LD0RE_1RC1RD_1LD---_1RB1RA_0LE1LD"}).str(),
+                "1RB0LC_1LD1LA_0RC1RB_1LE1LB_1RB---");
+    pass("lnfSymbolsAndMirror");
+}
+
+void canonicalIds()
+{
+    assertEqual(canonicalId({"1RB2LA1RA_1LB1LA2RC_1RZ1LC2RB"}), canonicalId({"2LC2LA1RA_2LZ1LC2RB_2RC1LB2RA"}));
+    assertEqual(canonicalId({"1RB2LB1RZ_2LA2RB1LB"}), canonicalId({"2RB2RZ1LB_1LA2LB1RB"}));
+    assertEqual(canonicalId(known::bb4Champion().rule()) != canonicalId(known::bbb4Champion().rule()), true);
+    // Small machines are packed exactly, and larger ones are hashed
+    assertEqual(canonicalId(known::bb5Champion().rule()) >> 63, 0);
+    assertEqual(canonicalId(known::bb6Champion().rule()) >> 63, 1);
+    assertEqual(canonicalId(known::antihydra().rule()) != canonicalId(known::bb6Champion().rule()), true);
+    // The 4x2 machines differ from each other in their IDs
+    boost::unordered_flat_set<uint64_t> ids;
+    for (auto &&code : {"1RB0RC_1LB0RD_1LC1LD_1RA1LD", "1RB1LB_1LA0LC_1RZ1LD_1RD0RA", "1RB1LC_1RD1RB_0RD0RC_1LD1LA",
+                        "1RB0LC_1LD0LA_1RC1RD_1LA0LD", "1RB0RC_1LB1LD_0RA0LD_1LA1RC"})
+        ids.insert(canonicalId({code}));
+    assertEqual(ids.size(), 5);
+    pass("canonicalIds");
+}
+
 int main()
 {
     lnf4x2Nop();
@@ -56,5 +87,7 @@ int main()
     lnf4x2Swap2();
     lnf5x2Swap();
     lnf5x2Rotate();
+    lnfSymbolsAndMirror();
+    canonicalIds();
     pass("=== All lnf tests passed ===");
 }
@@ -0,0 +1,106 @@
+#include "../pch.hpp"
+
+#include "../machine_db.hpp"
+#include "common.hpp"
+
+using namespace std;
+using namespace turing;
+using Int = int64_t;
+
+/// Encodes a machine in the bbchallenge format.
+string bbchallengeRecord(const turing_rule &rule)
+{
+    string s;
+    for (size_t i = 0; i < rule.numStates(); ++i)
+        for (size_t j = 0; j < rule.numSymbols(); ++j)
+        {
+            const auto &tr = rule[i, j];
+            if (tr.toState == -1)
+                s += string(3, '\0');
+            else
+            {
+                s += (char)tr.symbol;
+                s += (char)(tr.direction == direction::left);
+                s += (char)(tr.toState + 1);
+            }
+        }
+    return s;
+}
+
+void bbchallengeDatabase()
+{
+    const vector<string> codes{"1RB1LC_1RC1RB_1RD0LE_1LA1LD_---0LA", "1RB0LD_1LC0RA_1RA1LB_1LA1LE_---0RC",
+                               "1RB---_0RC0RE_1RD1RC_1LE0LA_1LD0LB", "1RB1RE_1LC0RA_0RD1LB_---1RA_0LB1LD"};
+    const auto dbPath = filesystem::temp_directory_path() / "turing-bbchallenge-test.db";
+    const auto indexPath = filesystem::temp_directory_path() / "turing-bbchallenge-test.index";
+    {
+        ofstream fout(dbPath, ios::binary | ios::trunc);
+        fout << string(MachineDatabase::bbchallengeHeaderSize, '\0');
+        for (auto &&code : codes)
+            fout << bbchallengeRecord(turing_rule{code});
+        ofstream index(indexPath, ios::binary | ios::trunc);
+        // Machines 3 and 1, big-endian
+        index << string{0, 0, 0, 3, 0, 0, 0, 1};
+    }
+    const MachineDatabase db{dbPath};
+    assertEqual(db.size(), codes.size());
+    for (size_t i = 0; i < codes.size(); ++i)
+    {
+        assertEqual(db[i].str(), codes[i]);
+        assertEqual(db.id(i), i);
+    }
+    const MachineIndex index{indexPath};
+    assertEqual(index.size(), 2);
+    assertEqual(index[0], 3);
+    assertEqual(index[1], 1);
+
+    vector<string> visited;
+    forEachMachine(db, &index, 0, 10, [&](uint64_t id, const turing_rule &rule) {
+        visited.push_back(to_string(id) + " " + rule.str());
+    });
+    assertEqual(visited.size(), 2);
+    assertEqual(visited[0], "3 " + codes[3]);
+    assertEqual(visited[1], "1 " + codes[1]);
+    visited.clear();
+    forEachMachine(db, nullptr, 1, 3, [&](uint64_t id, const turing_rule &) { visited.push_back(to_string(id)); });
+    assertEqual(visited.size(), 2);
+    assertEqual(visited[0], "1");
+
+    // Records of the wrong size are rejected
+    bool threw = false;
+    try
+    {
+        const MachineDatabase wrong{dbPath, 3, 2};
+    }
+    catch (const runtime_error &)
+    {
+        threw = true;
+    }
+    filesystem::remove(dbPath);
+    filesystem::remove(indexPath);
+    assertEqual(threw, true);
+    pass("bbchallengeDatabase");
+}
+
+void seedDatabase()
+{
+    const auto path = filesystem::temp_directory_path() / "turing-machine-db-seeds-test.bin";
+    {
+        ofstream fout(path, ios::binary | ios::trunc);
+        seeds::writeHeader(fout);
+        seeds::write(fout, seeds::seed_record::make(17, 0, turing_rule{"1RB1LA_1LA0RB"}));
+        seeds::write(fout, seeds::seed_record::make(42, 1, turing_rule{"1RB2LA1RA_1LB1LA2RC_1RZ1LC2RB"}));
+    }
+    const MachineDatabase db{path};
+    filesystem::remove(path);
+    assertEqual(db.size(), 2);
+    assertEqual(db.id(1), 42);
+    assertEqual(db[1].str(), "1RB2LA1RA_1LB1LA2RC_1RZ1LC2RB");
+    pass("seedDatabase");
+}
+
+int main()
+{
+    bbchallengeDatabase();
+    seedDatabase();
+}
@@ -1,4 +1,6 @@
 #include "../pch.hpp"
+#include "../engine/mapped.hpp"
+#include "../engine/specialized.hpp"
 #include "../turing.hpp"
 
 using namespace std;
@@ -19,6 +21,52 @@ void bb5Champion(size_t nSteps = 47176870)
          << " ns per step\n";
 }
 
+void bb5ChampionStepN(size_t nSteps = 47176870)
+{
+    auto m = known::bb5Champion();
+    auto t1 = now();
+    m.stepN(nSteps);
+    auto ns = duration_cast<std::chrono::nanoseconds>(now() - t1).count();
+    cout << setw(headerWidth) << "BB5 champion (stepN): " << m.steps() << " steps, " << (double)ns / m.steps()
+         << " ns per step\n";
+}
+
+void bb5ChampionPacked(size_t nSteps = 47176870)
+{
+    PackedTuringMachine<1> m{known::bb5Champion().rule()};
+    auto t1 = now();
+    for (size_t i = 0; i < nSteps; ++i)
+        if (!m.step().success)
+            break;
+    auto ns = duration_cast<std::chrono::nanoseconds>(now() - t1).count();
+    cout << setw(headerWidth) << "BB5 champion (packed): " << m.steps() << " steps, " << (double)ns / m.steps()
+         << " ns per step\n";
+}
+
+#ifdef TURING_MAPPED_TAPE
+void bb5ChampionMapped(size_t nSteps = 47176870)
+{
+    MappedTuringMachine m{known::bb5Champion().rule()};
+    auto t1 = now();
+    for (size_t i = 0; i < nSteps; ++i)
+        if (!m.step().success)
+            break;
+    auto ns = duration_cast<std::chrono::nanoseconds>(now() - t1).count();
+    cout << setw(headerWidth) << "BB5 champion (mapped): " << m.steps() << " steps, " << (double)ns / m.steps()
+         << " ns per step\n";
+}
+#endif
+
+void bb5ChampionSpecialized(size_t nSteps = 47176870)
+{
+    SpecializedTuringMachine<"1RB1LC_1RC1RB_1RD0LE_1LA1LD_1RZ0LA"> m;
+    auto t1 = now();
+    m.seek(nSteps);
+    auto ns = duration_cast<std::chrono::nanoseconds>(now() - t1).count();
+    cout << setw(headerWidth) << "BB5 champion (specialized): " << m.steps() << " steps, " << (double)ns / m.steps()
+         << " ns per step\n";
+}
+
 void cycler483328(size_t nSteps = 100000000)
 {
     TuringMachine m{"1RB1LC_0LA1RD_1LA0LC_0RB0RD"};
@@ -31,6 +79,52 @@ void cycler483328(size_t nSteps = 100000000)
          << " ns per step\n";
 }
 
+void cycler483328StepN(size_t nSteps = 100000000)
+{
+    TuringMachine m{"1RB1LC_0LA1RD_1LA0LC_0RB0RD"};
+    auto t1 = now();
+    m.stepN(nSteps);
+    auto ns = duration_cast<std::chrono::nanoseconds>(now() - t1).count();
+    cout << setw(headerWidth) << "T-cycler p483328 (stepN): " << m.steps() << " steps, " << (double)ns / m.steps()
+         << " ns per step\n";
+}
+
+void cycler483328Packed(size_t nSteps = 100000000)
+{
+    PackedTuringMachine<1> m{"1RB1LC_0LA1RD_1LA0LC_0RB0RD"};
+    auto t1 = now();
+    for (size_t i = 0; i < nSteps; ++i)
+        if (!m.step().success)
+            break;
+    auto ns = duration_cast<std::chrono::nanoseconds>(now() - t1).count();
+    cout << setw(headerWidth) << "T-cycler p483328 (packed): " << m.steps() << " steps, " << (double)ns / m.steps()
+         << " ns per step\n";
+}
+
+#ifdef TURING_MAPPED_TAPE
+void cycler483328Mapped(size_t nSteps = 100000000)
+{
+    MappedTuringMachine m{"1RB1LC_0LA1RD_1LA0LC_0RB0RD"};
+    auto t1 = now();
+    for (size_t i = 0; i < nSteps; ++i)
+        if (!m.step().success)
+            break;
+    auto ns = duration_cast<std::chrono::nanoseconds>(now() - t1).count();
+    cout << setw(headerWidth) << "T-cycler p483328 (mapped): " << m.steps() << " steps, " << (double)ns / m.steps()
+         << " ns per step\n";
+}
+#endif
+
+void cycler483328Specialized(size_t nSteps = 100000000)
+{
+    SpecializedTuringMachine<"1RB1LC_0LA1RD_1LA0LC_0RB0RD"> m;
+    auto t1 = now();
+    m.seek(nSteps);
+    auto ns = duration_cast<std::chrono::nanoseconds>(now() - t1).count();
+    cout << setw(headerWidth) << "T-cycler p483328 (specialized): " << m.steps() << " steps, "
+         << (double)ns / m.steps() << " ns per step\n";
+}
+
 // Manual compilation is about twice as fast. `1RB1LC_0LA1RD_1LA0LC_0RB0RD`
 void cycler483328Decompiled(size_t nSteps = 100000000) // NOLINT(readability-function-cognitive-complexity)
 {
@@ -95,11 +189,36 @@ void cycler32779478(size_t nSteps = 100000000)
          << " ns per step\n";
 }
 
+void cycler32779478Packed(size_t nSteps = 100000000)
+{
+    PackedTuringMachine<1> m{"1RB1LC_1RD1RB_0RD0RC_1LD1LA"};
+    auto t1 = now();
+    for (size_t i = 0; i < nSteps; ++i)
+        if (!m.step().success)
+            break;
+    auto ns = duration_cast<std::chrono::nanoseconds>(now() - t1).count();
+    cout << setw(headerWidth) << "T-cycler p1s32779478 (packed): " << m.steps() << " steps, " << (double)ns / m.steps()
+         << " ns per step\n";
+}
+
 int main()
 {
     cout << fixed << setprecision(2);
     bb5Champion();
+    bb5ChampionStepN();
+    bb5ChampionPacked();
+#ifdef TURING_MAPPED_TAPE
+    bb5ChampionMapped();
+#endif
+    bb5ChampionSpecialized();
     cycler483328();
+    cycler483328StepN();
+    cycler483328Packed();
+#ifdef TURING_MAPPED_TAPE
+    cycler483328Mapped();
+#endif
+    cycler483328Specialized();
     cycler483328Decompiled();
     cycler32779478();
+    cycler32779478Packed();
 }
@@ -0,0 +1,107 @@
+#include "../pch.hpp"
+
+#include "../seeds.hpp"
+#include "common.hpp"
+
+using namespace std;
+using namespace turing;
+using Int = int64_t;
+
+void seedsTextRoundTrip()
+{
+    const vector<pair<string, string>> lines{
+        {"cyclers", "      42\t1RB0LB_1LA0RC_0LA1RB\t120\t17"},
+        {"tcyclers", "    1234\t1RB1LA_0LC0RB_1LA---\t502\t3\t-4"},
+        {"tcyclers", "12345678\t1RB0RA_1LC1RB_0LA---\t?\t900\t6"},
+        {"bouncers", "     999\t1RB1LC_0LA0RB_1LA1RZ\t1000\t12"},
+        {"quintic bells", "123456789\t1RB0LB2LA_1LA2RB1RB\t5\t3000\t9"},
+        {"counters", "       7\t1RB1LA_1LA0RB\t44"},
+        {"unclassified", "  100000\t1RB0RD_1LC1LB_1RA0LB_0RE1RD_---0RA"},
+    };
+    for (auto &&[name, line] : lines)
+    {
+        const auto r = seeds::seed_record::parse(seeds::category(name), line);
+        assertEqual(r.categoryName(), name);
+        assertEqual(r.str(), line);
+    }
+    const auto r = seeds::seed_record::parse(seeds::category("tcyclers"), lines[2].second);
+    assertEqual(r.index, 12'345'678);
+    assertEqual(r.rule().str(), "1RB0RA_1LC1RB_0LA---");
+    assertEqual((int)r.numFields, 3);
+    assertEqual((int)r.unknownFields, 1);
+    assertEqual(r.fields[1], 900);
+    pass("seedsTextRoundTrip");
+}
+
+void seedsInvalid()
+{
+    const auto throws = [](string_view line) {
+        try
+        {
+            (void)seeds::seed_record::parse(0, line);
+        }
+        catch (const runtime_error &)
+        {
+            return true;
+        }
+        return false;
+    };
+    assertEqual(throws(""), true);
+    assertEqual(throws("       1"), true);
+    assertEqual(throws("       x\t1RB1LA_1LA0RB"), true);
+    assertEqual(throws("       1\tnot a machine"), true);
+    assertEqual(throws("       1\t1RB1LA_1LA0RB\t1\t2\t3\t4"), true);
+    assertEqual(throws("       1\t1RB1LA_1LA0RB\tfoo"), true);
+    assertEqual(throws("       1\t1RB1LA_1LA0RB\t1\t2\t3"), false);
+    pass("seedsInvalid");
+}
+
+void seedsDatabase()
+{
+    const auto path = filesystem::temp_directory_path() / "turing-seeds-test.bin";
+    {
+        ofstream fout(path, ios::binary | ios::trunc);
+        seeds::writeHeader(fout);
+        for (size_t i = 0; i < 1000; ++i)
+        {
+            auto r = seeds::seed_record::make(i, (uint8_t)(i % seeds::categories.size()),
+                                              turing_rule{"1RB1LC_1RC1RB_1RD0LE_1LA1LD_1RZ0LA"});
+            r.add(i * i);
+            r.add(seeds::unknown);
+            seeds::write(fout, r);
+        }
+    }
+    const seeds::Database db{path};
+    assertEqual(db.size(), 1000);
+    assertEqual(db[999].index, 999);
+    assertEqual(db[999].fields[0], 999 * 999);
+    assertEqual(db[500].categoryName(), seeds::categories[500 % seeds::categories.size()]);
+    assertEqual(db[0].rule().str(), "1RB1LC_1RC1RB_1RD0LE_1LA1LD_1RZ0LA");
+    assertEqual(db[0].str(), "       0\t1RB1LC_1RC1RB_1RD0LE_1LA1LD_1RZ0LA\t0\t?");
+    size_t n = 0;
+    for (auto &&r : db)
+        n += r.index == n ? 1 : 0;
+    assertEqual(n, 1000);
+
+    // A partial record is rejected
+    filesystem::resize_file(path, filesystem::file_size(path) - 1);
+    bool threw = false;
+    try
+    {
+        const seeds::Database truncated{path};
+    }
+    catch (const runtime_error &)
+    {
+        threw = true;
+    }
+    filesystem::remove(path);
+    assertEqual(threw, true);
+    pass("seedsDatabase");
+}
+
+int main()
+{
+    seedsTextRoundTrip();
+    seedsInvalid();
+    seedsDatabase();
+}
@@ -0,0 +1,132 @@
+#include "../pch.hpp"
+
+#include "../decide/tcycler.hpp"
+#include "../snapshot.hpp"
+#include "common.hpp"
+
+using namespace std;
+using namespace turing;
+using Int = int64_t;
+
+void snapshotRoundTrip()
+{
+    for (auto &&code : {"1RB1LC_1RC1RB_1RD0LE_1LA1LD_1RZ0LA", "1RB2LA1RA_1LB1LA2RC_1RZ1LC2RB",
+                        "1RB1RA_0LC1LE_1LD1LC_1LA0LB_1LF1RE_---0RA"})
+    {
+        TuringMachine m{code};
+        m.seek(123'456);
+        const auto bytes = snapshot::encode(m);
+        auto resumed = snapshot::decode(bytes);
+        assertEqual(resumed.ruleStr(), m.ruleStr());
+        assertEqual(resumed.steps(), m.steps());
+        assertEqual(resumed.str(), m.str());
+        // The tape is run-length encoded, so it is much smaller than one byte per cell.
+        assertEqual(bytes.size() < m.tape().size(), true);
+        m.seek(1'000'000);
+        resumed.seek(1'000'000);
+        assertEqual(resumed.str(), m.str());
+    }
+    pass("snapshotRoundTrip");
+}
+
+void snapshotHalted()
+{
+    auto m = known::bb5Champion();
+    m.seek(47'176'870);
+    const auto resumed = snapshot::decode(snapshot::encode(m));
+    assertEqual(resumed.halted(), true);
+    assertEqual(resumed.steps(), 47'176'870);
+    assertEqual(resumed.tape().sigma(), 4098);
+    pass("snapshotHalted");
+}
+
+void snapshotCorrupt()
+{
+    TuringMachine m{"1RB1LC_1RC1RB_1RD0LE_1LA1LD_1RZ0LA"};
+    m.seek(1000);
+    const auto bytes = snapshot::encode(m);
+    const auto throws = [](string data) {
+        try
+        {
+            (void)snapshot::decode(data);
+        }
+        catch (const runtime_error &)
+        {
+            return true;
+        }
+        return false;
+    };
+    assertEqual(throws(""), true);
+    assertEqual(throws("not a snapshot"), true);
+    assertEqual(throws(bytes.substr(0, bytes.size() - 1)), true);
+    assertEqual(throws(bytes + '\0'), true);
+    for (size_t i = 0; i < bytes.size(); i += 7)
+    {
+        auto flipped = bytes;
+        flipped[i] ^= 0x10;
+        assertEqual(throws(flipped), true);
+    }
+    assertEqual(throws(bytes), false);
+    // A state out of range is rejected even with a valid checksum
+    const auto withState = [&](int32_t state) {
+        auto data = bytes.substr(0, bytes.size() - sizeof(uint64_t));
+        const size_t at = snapshot::magic.size() + 4 + m.rule().str().size();
+        for (size_t i = 0; i < sizeof(state); ++i)
+            data[at + i] = (char)((uint32_t)state >> 8 * i);
+        snapshot::writer w;
+        w.putBytes(data);
+        return std::move(w).finish();
+    };
+    assertEqual(withState(m.state()), bytes);
+    for (const int32_t state : {-2, 5, 24, 26, 0x7fff'ffff})
+        assertEqual(throws(withState(state)), true);
+    for (const int32_t state : {-1, 0, 4, 'Z' - 'A'})
+        assertEqual(throws(withState(state)), false);
+    // A tape longer than the steps allow is rejected before it is allocated
+    const auto withRun = [&](uint64_t steps, uint64_t length) {
+        const auto code = m.rule().str();
+        snapshot::writer w;
+        w.putBytes(snapshot::magic);
+        w.put(snapshot::version);
+        w.put(uint8_t{0});
+        w.put((uint16_t)code.size());
+        w.putBytes(code);
+        w.put(int32_t{0});
+        w.put(steps);
+        w.put(int64_t{0});
+        w.put(int64_t{0});
+        w.put(uint64_t{1});
+        w.put(symbol_type{1});
+        w.putVarint(length);
+        return std::move(w).finish();
+    };
+    assertEqual(throws(withRun(10, 11)), false);
+    assertEqual(throws(withRun(10, 12)), true);
+    assertEqual(throws(withRun(std::numeric_limits<uint64_t>::max(), uint64_t{1} << 41)), true);
+    pass("snapshotCorrupt");
+}
+
+void snapshotFile()
+{
+    const auto path = filesystem::temp_directory_path() / "turing-snapshot-test.snap";
+    TuringMachine m{"1RB0RC_1LB1LD_0RA0LD_1LA1RC"};
+    m.seek(50'000);
+    snapshot::save(m, path);
+    auto loaded = snapshot::load(path);
+    filesystem::remove(path);
+    assertEqual(loaded.str(), m.str());
+    // Deciders can start from a snapshot instead of a blank tape.
+    const auto res = CyclerDecider{}.findPeriodOnly(loaded, 100'000, 1000);
+    assertEqual(res.period > 0, false);
+    const auto tres = TranslatedCyclerDecider{}.findPeriodOnly(loaded, 1'000'000, 1000);
+    assertEqual(tres.period > 0, true);
+    pass("snapshotFile");
+}
+
+int main()
+{
+    snapshotRoundTrip();
+    snapshotHalted();
+    snapshotCorrupt();
+    snapshotFile();
+}
@@ -1,119 +1,112 @@
-// The point of this program is to compile C# code corresponding to a Turing machine, and then to decompile it with
-// ILSpy. You will need to edit the ILSpy path.
+// Compiles a Turing machine to native code, and either runs it or prints the generated code.
 
 #include "pch.hpp"
 
+#include "engine/compiled.hpp"
+
 using namespace std;
+using namespace turing;
 
-ostream &printStep(string_view triple, size_t numStates, ostream &o)
+auto run(turing_rule rule, size_t numSteps, const compile_options &options)
 {
-    if (triple == "---")
-        triple = "1RZ";
-    char maxState = 'A' + numStates - 1;
-    char symbol = triple[0];
-    char dir = toupper(triple[1]);
-    char newState = toupper(triple[2]);
-    if (newState < 'A' || newState > maxState)
-        o << "return ";
-    o << "t.Step(" << symbol << ", " << "Direction." << (dir == 'R' ? "Right" : "Left") << ", '" << newState << "');";
-    if (newState >= 'A' && newState <= maxState)
-        o << " goto " << newState << ";";
-    return o;
+    CompiledTuringMachine m{rule, options};
+    m.seek(numSteps);
+    return pair{m.steps(), m.tape()};
 }
 
-ostream &printMain(string_view code, ostream &o)
+int main(int argc, char *argv[])
 {
-    return o << R"(using System;
-using System.Collections.Generic;
+    constexpr string_view help = R"(Compiles a Turing machine to native code and runs it, or prints the generated code
 
-bool quiet = args.Length > 0 && (args[0] == "-q" || args[0] == "-quiet");
-var steps = MyTM();
-Console.WriteLine($"The Turing machine )"
-             << code << R"( halted after {steps} steps.");
-)";
-}
+Usage: ./run tmcompiler <TM> [n]
 
-ostream &printClasses(ostream &o)
-{
-    return o << R"(public enum Direction : byte { Left, Right }
-public class Tape(bool debug) { private readonly List<byte> _data = [0]; private int _index = 0; private int _steps = 0; private char _state = 'A'; public byte Value => _data[_index]; public byte Peek(int delta) { int i = _index + delta; return i >= 0 && i < _data.Count ? _data[i] : (byte)0; } public int Step(byte b, Direction dir, char newState = '\0') { _data[_index] = b; if (newState != '\0') _state = newState; if (dir == Direction.Left) MoveLeft(); else MoveRight(); _steps++; if (debug) Console.WriteLine(this); return _steps; } public int Steps => _steps; public override string ToString() { var sb = new System.Text.StringBuilder(); sb.Append($"{_steps,8}"); sb.Append(' '); for (int i = 0; i < _data.Count; ++i) { if (i == _index) sb.Append(GetStyle(_state)); sb.Append(_data[i] == 0 ? '_' : (char)('0' + _data[i])); if (i == _index) sb.Append("\x1B[0m"); } return sb.ToString(); } private void MoveLeft() { if (_index == 0) _data.Insert(0, 0); else --_index; } private void MoveRight() { if (_index == _data.Count - 1) _data.Add(0); ++_index; } private static string GetStyle(char state) => state switch { 'A' => "\x1B[41m", 'B' => "\x1B[48;2;255;128;0m", 'C' => "\x1B[44m", 'D' => "\x1B[42m", 'E' => "\x1B[45m", 'F' => "\x1B[46m", 'Z' => "\x1B[7m", _ => "", }; }
-)";
-}
+Arguments:
+  <TM>  The Turing machine
+  [n]   Number of steps (default: until the machine halts)
 
-ostream &printTM(string_view code, ostream &o)
-{
-    o << "// " << code << R"(
-int MyTM()
-{
-    Tape t = new(!quiet);
-    if (!quiet) { Console.WriteLine(t.ToString()); }
+Options:
+  -h, --help           Show this help message
+  -s, --source         Print the generated C++ code instead of running it
+  -S, --asm            Print the generated assembly instead of running it
+  --cxx <compiler>     C++ compiler (default: $TURING_CXX, or clang++)
+  --flags <flags>      Compiler flags (default: -O2 -march=native)
+  --cache-dir <dir>    Where to cache compiled machines (default:
+                       $TURING_CACHE_DIR, or a turing-compiled folder in the
+                       temporary directory)
+  -v, --verbose        Show the compiler command
 )";
-    auto states =
-        it::split(string(code), '_').map fun(s, it::range(0, s.size() - 1, 3).map fun(i, s.substr(i, 3)).to()).to();
-    for (size_t i = 0; i < states.size(); ++i)
+    const span args(argv, argc);
+    turing_rule rule;
+    size_t numSteps = numeric_limits<size_t>::max();
+    bool source = false;
+    bool assembly = false;
+    compile_options options;
+    int argPos = 0;
+    for (int i = 1; i < argc; ++i)
     {
-        o << (char)('A' + i) << ": switch (t.Value) {";
-        for (size_t j = 0; j < states[i].size(); ++j)
+        if (strcmp(args[i], "-h") == 0 || strcmp(args[i], "--help") == 0)
+        {
+            cout << help;
+            return 0;
+        }
+        if (strcmp(args[i], "-s") == 0 || strcmp(args[i], "--source") == 0)
+            source = true;
+        else if (strcmp(args[i], "-S") == 0 || strcmp(args[i], "--asm") == 0)
+            assembly = true;
+        else if (strcmp(args[i], "--cxx") == 0)
+            options.compiler = args[++i];
+        else if (strcmp(args[i], "--flags") == 0)
+            options.flags = args[++i];
+        else if (strcmp(args[i], "--cache-dir") == 0)
+            options.cacheDir = args[++i];
+        else if (strcmp(args[i], "-v") == 0 || strcmp(args[i], "--verbose") == 0)
+            options.verbose = true;
+        else if (argPos == 0)
         {
-            if (j == states[i].size() - 1)
-                o << " default: ";
-            else
-                o << " case " << j << ": ";
-            printStep(states[i][j], states.size(), o);
+            ++argPos;
+            rule = turing_rule(args[i]);
+            if (rule.empty())
+            {
+                cerr << ansi::red << "Invalid TM: " << ansi::reset << args[i] << '\n' << help;
+                return 0;
+            }
+        }
+        else if (argPos == 1)
+        {
+            ++argPos;
+            numSteps = parseNumber(args[i]);
+        }
+        else
+        {
+            cerr << ansi::red << "Unexpected argument: " << ansi::reset << args[i] << '\n' << help;
+            return 0;
         }
-        o << " }\n";
     }
-    return o << "}\n";
-}
-
-auto compile(string_view code, bool decompile, bool quiet)
-{
-    cout << "Compiling C# code for Turing machine " << code << "...\n";
-    string p = string("C:/Temp/TMs/");
-    p += code;
-    p += ".cs";
-    string outputPath = (string("C:/Temp/TMs/") + string(code) + ".exe");
-    ofstream fout(p);
-    printMain(code, fout) << '\n';
-    printTM(code, fout) << '\n';
-    printClasses(fout);
-    fout.close();
-    int res = system(
-        (string("\"C:/Program Files/Microsoft Visual Studio/2022/Community/MSBuild/Current/Bin/Roslyn/csc.exe\" ") + p +
-         " -nologo -o -out:" + outputPath)
-            .c_str());
-    if (res == 0)
+    if (rule.empty())
     {
-        cout << ansi::green << "Compile succeeded." << ansi::reset << '\n';
-        if (decompile)
-            system((string("C:/Apps/ILSpy/ILSpy.exe ") + outputPath + " -n:T:Program").c_str());
-        else
+        cout << help;
+        return 0;
+    }
+    if (source)
+    {
+        cout << generateSource(rule);
+        return 0;
+    }
+    try
+    {
+        if (assembly)
         {
-            auto t1 = now();
-            system((outputPath + (quiet ? " -q" : "")).c_str());
-            cout << ansi::cyan << "Program finished in ";
-            io::print(now() - t1) << "." << ansi::reset;
+            const auto src = CompiledTuringMachine::compile(rule, options).replace_extension(".cpp");
+            const auto command = options.compiler + " " + options.flags + " -S -o - \"" + src.string() + "\"";
+            if (options.verbose)
+                cout << command << '\n';
+            return system(command.c_str());
         }
+        printTiming(run, rule, numSteps, options);
     }
-    else
+    catch (const runtime_error &e)
     {
-        cerr << ansi::red << "Compile failed." << ansi::reset << '\n';
-        remove(p.c_str());
+        cerr << ansi::red << e.what() << ansi::reset << '\n';
+        return 1;
     }
 }
-
-int main(int argc, char *argv[])
-{
-    auto args = span(argv, argc);
-    const char *code = "1RB1LC_0LA1RD_1LA0LC_0RB0RD";
-    bool decompile = false;
-    bool quiet = false;
-    for (auto &&arg : args | views::drop(1))
-        if (strcmp(arg, "-dec") == 0 || strcmp(arg, "-decompile") == 0)
-            decompile = true;
-        else if (strcmp(arg, "-q") == 0 || strcmp(arg, "-quiet") == 0)
-            quiet = true;
-        else
-            code = arg;
-    compile(code, decompile, quiet);
-}